@@ -0,0 +1,41 @@
+#include "alloccount.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local uint64_t t_allocations = 0;
+}
+
+uint64_t alloccount::thread()
+{
+    return t_allocations;
+}
+
+#ifdef _DEBUG
+
+// The array and nothrow forms go through this one
+void* operator new(std::size_t size)
+{
+    t_allocations++;
+
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#endif
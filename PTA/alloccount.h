@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocations made through operator new, per thread.
+//
+// Debug builds replace the global operator new to count them, so the parser
+// can report what an item cost. Release builds count nothing.
+namespace alloccount
+{
+#ifdef _DEBUG
+    constexpr bool enabled = true;
+#else
+    constexpr bool enabled = false;
+#endif
+
+    // Allocations made on the calling thread so far
+    uint64_t thread();
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "ptadb.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Byte trie over a sorted list of keys, shared by the stat template trie and
+// the affix name tries.
+//
+// Nodes and edges live in two flat arrays, node 0 is the root, and the edges
+// of a node are contiguous and sorted so a step is a binary search. Every node
+// carries a value of type T that the owner fills in for the keys ending there.
+// A snapshot stores both arrays as they are, so a restored trie is walked in
+// place in the mapped file. build() fills the same arrays with an automaton
+// instead, whose nodes can be reached over more than one edge.
+template <typename T>
+class byte_trie
+{
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    bool   empty() const { return m_nodes.empty(); }
+    size_t size() const { return m_nodes.size(); }
+
+    void clear()
+    {
+        m_nodes.clear();
+        m_edges.clear();
+    }
+
+    const T& value(uint32_t node) const { return m_nodes[node].value; }
+
+    // Builds the trie from keys sorted the way std::string_view compares. text(key)
+    // gives the bytes of a key and mark(value, key) is called for every key that
+    // ends at a node, in key order
+    template <typename Key, typename TextFn, typename MarkFn>
+    void compile(const std::vector<Key>& keys, TextFn text, MarkFn mark)
+    {
+        clear();
+
+        if (keys.empty())
+        {
+            return;
+        }
+
+        std::vector<node> nodes;
+        std::vector<edge> edges;
+
+        compileNode(nodes, edges, keys, text, mark, 0, keys.size(), 0);
+
+        nodes.shrink_to_fit();
+        edges.shrink_to_fit();
+
+        m_nodes.assign(std::move(nodes));
+        m_edges.assign(std::move(edges));
+    }
+
+    // Builds an automaton instead of a tree, a node may be reached over any number of edges.
+    // expand(n, value, edges) fills in the value of node n and its edges as (label, target)
+    // sorted by label, and returns false once n is past the last node. Targets may be nodes
+    // that expand has not been called for yet
+    template <typename ExpandFn>
+    void build(ExpandFn expand)
+    {
+        clear();
+
+        std::vector<node>                      nodes;
+        std::vector<edge>                      edges;
+        std::vector<std::pair<char, uint32_t>> out;
+
+        for (uint32_t n = 0;; n++)
+        {
+            T value = {};
+            out.clear();
+
+            if (!expand(n, value, out))
+            {
+                break;
+            }
+
+            nodes.push_back({static_cast<uint32_t>(edges.size()), static_cast<uint32_t>(out.size()), value});
+
+            for (const auto& [label, target] : out)
+            {
+                edges.push_back({target, label});
+            }
+        }
+
+        nodes.shrink_to_fit();
+        edges.shrink_to_fit();
+
+        m_nodes.assign(std::move(nodes));
+        m_edges.assign(std::move(edges));
+    }
+
+    void save(ptadb::SectionWriter& w) const
+    {
+        w.array(m_nodes);
+        w.array(m_edges);
+    }
+
+    // Views the arrays of a saved trie in place
+    bool restore(ptadb::SectionReader& r)
+    {
+        return (r.array(m_nodes) && r.array(m_edges));
+    }
+
+    // Calls fn(label, target) for every edge of node, in label order
+    template <typename Fn>
+    void children(uint32_t node, Fn fn) const
+    {
+        for (uint32_t e = 0; e < m_nodes[node].edgeCount; e++)
+        {
+            const edge& ed = m_edges[m_nodes[node].firstEdge + e];
+            fn(ed.label, ed.target);
+        }
+    }
+
+    // Node reached from node over label, npos if there is none
+    uint32_t child(uint32_t node, char label) const
+    {
+        auto first = m_edges.begin() + m_nodes[node].firstEdge;
+        auto last  = first + m_nodes[node].edgeCount;
+
+        // Edges are sorted the way string_view compares, as unsigned char
+        auto it = std::lower_bound(first, last, label, [](const edge& e, char c) { return uint8_t(e.label) < uint8_t(c); });
+
+        return ((it != last && it->label == label) ? it->target : npos);
+    }
+
+private:
+    struct node
+    {
+        uint32_t firstEdge = 0;
+        uint32_t edgeCount = 0;
+        T        value     = {};
+    };
+
+    struct edge
+    {
+        uint32_t target;
+        char     label;
+        char     reserved[3] = {};
+    };
+
+    template <typename Key, typename TextFn, typename MarkFn>
+    static uint32_t compileNode(std::vector<node>& nodes, std::vector<edge>& edges, const std::vector<Key>& keys, TextFn& text, MarkFn& mark, size_t begin,
+                                size_t end, size_t depth)
+    {
+        uint32_t n = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+
+        // Keys that end here sort before the ones that continue
+        for (; begin < end && std::string_view(text(keys[begin])).size() == depth; begin++)
+        {
+            mark(nodes[n].value, keys[begin]);
+        }
+
+        auto at = [&](size_t i) { return std::string_view(text(keys[i]))[depth]; };
+
+        // Reserve the edges of this node first so they stay contiguous
+        uint32_t count = 0;
+
+        for (size_t i = begin; i < end; count++)
+        {
+            char c = at(i);
+
+            while (i < end && at(i) == c)
+            {
+                i++;
+            }
+        }
+
+        uint32_t first = static_cast<uint32_t>(edges.size());
+
+        nodes[n].firstEdge = first;
+        nodes[n].edgeCount = count;
+        edges.resize(first + count);
+
+        for (uint32_t e = 0; begin < end; e++)
+        {
+            char   c    = at(begin);
+            size_t next = begin;
+
+            while (next < end && at(next) == c)
+            {
+                next++;
+            }
+
+            uint32_t target = compileNode(nodes, edges, keys, text, mark, begin, next, depth + 1);
+
+            edges[first + e] = {target, c};
+            begin            = next;
+        }
+
+        return n;
+    }
+
+private:
+    ptadb::array<node> m_nodes;
+    ptadb::array<edge> m_edges;
+};
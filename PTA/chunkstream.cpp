@@ -0,0 +1,81 @@
+#include "chunkstream.h"
+
+#include "ptadb.h"
+
+#include <limits>
+
+ChunkStream::ChunkStream() : m_stream(this), m_hash(ptadb::hash_seed) {}
+
+void ChunkStream::push(std::string chunk)
+{
+    if (chunk.empty())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_chunks.push_back(std::move(chunk));
+    }
+
+    m_cv.notify_one();
+}
+
+void ChunkStream::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+
+    m_cv.notify_one();
+}
+
+void ChunkStream::abort()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed  = true;
+        m_aborted = true;
+        m_chunks.clear();
+    }
+
+    m_cv.notify_one();
+}
+
+void ChunkStream::drain()
+{
+    // Consume whatever the parser left behind so that the fingerprint covers the whole document
+    m_stream.ignore(std::numeric_limits<std::streamsize>::max());
+}
+
+bool ChunkStream::aborted() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_aborted;
+}
+
+ChunkStream::int_type ChunkStream::underflow()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_cv.wait(lock, [this] { return !m_chunks.empty() || m_closed; });
+
+        if (m_chunks.empty() || m_aborted)
+        {
+            return traits_type::eof();
+        }
+
+        m_current = std::move(m_chunks.front());
+        m_chunks.pop_front();
+    }
+
+    m_hash = ptadb::hash(m_current.data(), m_current.size(), m_hash);
+    m_size += m_current.size();
+
+    char* begin = m_current.data();
+    setg(begin, begin, begin + m_current.size());
+
+    return traits_type::to_int_type(*gptr());
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+
+// A blocking single producer/single consumer byte stream.
+//
+// The producer pushes chunks as they arrive off the network while the consumer
+// reads them through a std::istream on another thread, so a parser can work on
+// a document before it has finished downloading. The consumer also fingerprints
+// everything it reads.
+class ChunkStream : private std::streambuf
+{
+public:
+    ChunkStream();
+
+    // Producer
+    void push(std::string chunk);
+    void close();
+    void abort();
+
+    // Consumer
+    std::istream& stream() { return m_stream; }
+    void          drain();
+
+    uint64_t hash() const { return m_hash; }
+    size_t   size() const { return m_size; }
+    bool     aborted() const;
+
+protected:
+    int_type underflow() override;
+
+private:
+    std::istream m_stream;
+
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::string> m_chunks;
+    bool                    m_closed  = false;
+    bool                    m_aborted = false;
+
+    // Owned by the consumer
+    std::string m_current;
+    uint64_t    m_hash;
+    size_t      m_size = 0;
+};
@@ -40,9 +40,23 @@ GeneralPage::GeneralPage(json& set, QWidget* parent) : QWidget(parent)
 
     connect(logToFile, &QCheckBox::stateChanged, [=, &set](int checked) { set[PTA_CONFIG_LOGFILE] = (checked == Qt::Checked); });
 
+    // ------------------Startup profile
+    QCheckBox* startupReport = new QCheckBox("Save startup profile report");
+    startupReport->setChecked(settings.value(PTA_CONFIG_STARTUP_REPORT, false).toBool());
+
+    connect(startupReport, &QCheckBox::stateChanged, [=, &set](int checked) { set[PTA_CONFIG_STARTUP_REPORT] = (checked == Qt::Checked); });
+
+    // ------------------Parse cache
+    QCheckBox* persistParseCache = new QCheckBox("Remember parsed items across restarts");
+    persistParseCache->setChecked(settings.value(PTA_CONFIG_PERSIST_PARSE_CACHE, false).toBool());
+
+    connect(persistParseCache, &QCheckBox::stateChanged, [=, &set](int checked) { set[PTA_CONFIG_PERSIST_PARSE_CACHE] = (checked == Qt::Checked); });
+
     QVBoxLayout* configLayout = new QVBoxLayout;
     configLayout->addLayout(logLayout);
     configLayout->addWidget(logToFile);
+    configLayout->addWidget(startupReport);
+    configLayout->addWidget(persistParseCache);
 
     configGroup->setLayout(configLayout);
 
@@ -166,6 +180,15 @@ HotkeyPage::HotkeyPage(json& set, QWidget* parent) : QWidget(parent)
 
     formLayout->addRow(sclLabel);
 
+    // ------------------Advanced copy
+
+    QCheckBox* advCopyLabel = new QCheckBox(tr("Copy items with Ctrl+Alt+C to read their mod names and tiers"));
+    advCopyLabel->setChecked(settings.value(PTA_CONFIG_ADVANCED_COPY_ENABLED, false).toBool());
+
+    connect(advCopyLabel, &QCheckBox::stateChanged, [=, &set](int checked) { set[PTA_CONFIG_ADVANCED_COPY_ENABLED] = (checked == Qt::Checked); });
+
+    formLayout->addRow(advCopyLabel);
+
     // =============END
 
     configGroup->setLayout(formLayout);
@@ -0,0 +1,515 @@
+#include "dataloader.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QtConcurrent>
+
+DataLoader::DataLoader(QNetworkAccessManager* netmanager, QObject* parent) : QObject(parent), m_manager(netmanager) {}
+
+void DataLoader::add(const QString& name, const QUrl& url, ingest_fn ingest, const QStringList& deps)
+{
+    add(name, QString(), url, ingest, deps);
+}
+
+void DataLoader::add(const QString& name, const QString& file, const QUrl& url, ingest_fn ingest, const QStringList& deps)
+{
+    Source src;
+
+    src.name   = name;
+    src.file   = file;
+    src.url    = url;
+    src.ingest = ingest;
+    src.deps   = deps;
+
+    m_sources.push_back(std::move(src));
+}
+
+void DataLoader::addStream(const QString& name, const QUrl& url, stream_fn ingest, const QStringList& deps)
+{
+    Source src;
+
+    src.name         = name;
+    src.url          = url;
+    src.streamIngest = ingest;
+    src.deps         = deps;
+
+    m_sources.push_back(std::move(src));
+}
+
+void DataLoader::revalidate(const QString& name, const QByteArray& etag, const QByteArray& lastModified, unchanged_fn unchanged)
+{
+    auto it = std::find_if(m_sources.begin(), m_sources.end(), [&](const Source& s) { return s.name == name; });
+
+    if (it != m_sources.end())
+    {
+        it->etag         = etag;
+        it->lastModified = lastModified;
+        it->unchanged    = unchanged;
+    }
+}
+
+QByteArray DataLoader::etag(const QString& name) const
+{
+    auto src = find(name);
+    return (src ? src->etag : QByteArray());
+}
+
+QByteArray DataLoader::lastModified(const QString& name) const
+{
+    auto src = find(name);
+    return (src ? src->lastModified : QByteArray());
+}
+
+DataLoader::Profile DataLoader::profile(const QString& name) const
+{
+    auto src = find(name);
+    return (src ? src->profile : Profile());
+}
+
+void DataLoader::start()
+{
+    m_done   = 0;
+    m_failed = false;
+    m_error.clear();
+
+    if (m_sources.empty())
+    {
+        emit finished();
+        return;
+    }
+
+    // Catch typos in dependency lists before they turn into a hang
+    for (const auto& src : m_sources)
+    {
+        for (const auto& dep : src.deps)
+        {
+            if (!find(dep))
+            {
+                fail("Dataset " + src.name + " depends on unknown dataset " + dep);
+                return;
+            }
+        }
+    }
+
+    // Every stream holds on to its thread until its download completes
+    int streams = std::count_if(m_sources.begin(), m_sources.end(), [](const Source& s) { return bool(s.streamIngest); });
+    m_streamPool.setMaxThreadCount(std::max(1, streams));
+
+    // Fire off every request at once
+    for (size_t i = 0; i < m_sources.size() && !m_failed; i++)
+    {
+        fetch(i);
+    }
+
+    schedule();
+}
+
+void DataLoader::abort()
+{
+    if (m_done < m_sources.size())
+    {
+        fail("Loading aborted");
+    }
+}
+
+void DataLoader::fetch(size_t idx)
+{
+    auto& src = m_sources[idx];
+
+    if (!src.timer.isValid())
+    {
+        src.timer.start();
+    }
+
+    if (!src.file.isEmpty())
+    {
+        QFile file(src.file);
+
+        if (file.open(QIODevice::ReadOnly))
+        {
+            src.payload = file.readAll();
+            src.state   = load_state::fetched;
+
+            src.profile.source  = origin::local_file;
+            src.profile.bytes   = src.payload.size();
+            src.profile.fetchMs = src.timer.nsecsElapsed() / 1e6;
+            return;
+        }
+    }
+
+    if (!src.url.isValid())
+    {
+        fail("Cannot open " + src.file);
+        return;
+    }
+
+    QNetworkRequest request(src.url);
+
+    // The dataset snapshot is the cache. Left to the disk cache of the manager, Qt would send
+    // its own validators and answer a 304 with the cached body, so the snapshot is never reused
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+
+    if (src.unchanged)
+    {
+        if (!src.etag.isEmpty())
+        {
+            request.setRawHeader("If-None-Match", src.etag);
+        }
+
+        if (!src.lastModified.isEmpty())
+        {
+            request.setRawHeader("If-Modified-Since", src.lastModified);
+        }
+    }
+
+    auto reply = m_manager->get(request);
+    src.reply  = reply;
+    src.state  = load_state::fetching;
+
+    if (src.streamIngest)
+    {
+        src.stream = std::make_shared<ChunkStream>();
+
+        connect(reply, &QNetworkReply::readyRead, this, [=]() {
+            auto& s = m_sources[idx];
+
+            if (s.received == 0 && sameDocument(s, reply))
+            {
+                // Settle it before any of the body reaches the parser
+                reply->disconnect(this);
+                reply->abort();
+                reply->deleteLater();
+                s.reply = nullptr;
+
+                notModified(idx);
+                return;
+            }
+
+            QByteArray chunk = reply->readAll();
+            bool       first = (s.received == 0);
+
+            s.received += chunk.size();
+            s.stream->push(chunk.toStdString());
+
+            if (first && s.received > 0)
+            {
+                schedule();
+            }
+        });
+    }
+
+    connect(reply, &QNetworkReply::finished, this, [=]() { handleReply(idx, reply); });
+}
+
+void DataLoader::handleReply(size_t idx, QNetworkReply* reply)
+{
+    auto& src = m_sources[idx];
+
+    reply->deleteLater();
+    src.reply = nullptr;
+
+    if (m_failed)
+    {
+        return;
+    }
+
+    if (reply->error() != QNetworkReply::NoError)
+    {
+        fail("PAPI: Error retrieving " + reply->url().toString() + " - " + reply->errorString());
+        return;
+    }
+
+    src.profile.fetchMs = src.timer.nsecsElapsed() / 1e6;
+
+    // A stream that is already being parsed was checked on its first chunk
+    bool unchanged = (src.received == 0 && sameDocument(src, reply));
+
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304 || unchanged)
+    {
+        notModified(idx);
+        return;
+    }
+
+    src.etag         = reply->rawHeader("ETag");
+    src.lastModified = reply->rawHeader("Last-Modified");
+
+    if (src.stream)
+    {
+        QByteArray chunk = reply->readAll();
+
+        src.received += chunk.size();
+        src.stream->push(chunk.toStdString());
+        src.stream->close();
+    }
+    else
+    {
+        src.payload  = reply->readAll();
+        src.received = src.payload.size();
+    }
+
+    if (!src.received)
+    {
+        fail("PAPI: Error retrieving " + reply->url().toString() + " - returned no data.");
+        return;
+    }
+
+    src.profile.source = origin::network;
+    src.profile.bytes  = src.received;
+
+    if (src.state == load_state::fetching)
+    {
+        src.state = load_state::fetched;
+    }
+
+    schedule();
+}
+
+void DataLoader::notModified(size_t idx)
+{
+    auto& src = m_sources[idx];
+
+    if (src.stream)
+    {
+        src.stream->close();
+    }
+
+    src.profile.source  = origin::not_modified;
+    src.profile.fetchMs = src.timer.nsecsElapsed() / 1e6;
+
+    src.notModified = true;
+    src.state       = load_state::fetched;
+
+    schedule();
+}
+
+bool DataLoader::sameDocument(const Source& src, QNetworkReply* reply) const
+{
+    // Some servers ignore the conditional headers, but a full response with the
+    // ETag of the copy the caller has is still that copy
+    return (src.unchanged && !src.etag.isEmpty() && reply->rawHeader("ETag") == src.etag);
+}
+
+void DataLoader::schedule()
+{
+    if (m_failed)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < m_sources.size(); i++)
+    {
+        auto& src = m_sources[i];
+
+        if (!ready(src) || !depsDone(src))
+        {
+            continue;
+        }
+
+        src.state = load_state::ingesting;
+
+        auto watcher = new QFutureWatcher<QString>(this);
+
+        connect(watcher, &QFutureWatcher<QString>::finished, this, [=]() {
+            watcher->deleteLater();
+
+            auto& s = m_sources[i];
+
+            QString err = watcher->result();
+
+            // Release the raw payload as soon as it is ingested
+            s.payload.clear();
+            s.state = load_state::done;
+
+            s.profile.totalMs = s.timer.nsecsElapsed() / 1e6;
+
+            if (m_failed)
+            {
+                return;
+            }
+
+            if (!err.isEmpty())
+            {
+                fail("Failed to load " + s.name + ": " + err);
+                return;
+            }
+
+            if (s.stale)
+            {
+                // The server says nothing changed but the caller could not use its copy,
+                // start over with a plain request
+                qInfo() << "Cached copy of" << s.name << "is unusable, requesting it again";
+
+                s.stale       = false;
+                s.notModified = false;
+                s.unchanged   = nullptr;
+                s.received    = 0;
+                s.stream.reset();
+                s.state = load_state::pending;
+
+                fetch(i);
+                schedule();
+                return;
+            }
+
+            m_done++;
+
+            emit datasetLoaded(s.name);
+
+            if (m_done == m_sources.size())
+            {
+                emit finished();
+                return;
+            }
+
+            // Release anything that was waiting on this dataset
+            schedule();
+        });
+
+        if (src.notModified)
+        {
+            unchanged_fn unchanged = src.unchanged;
+            bool*        stale     = &src.stale;
+            double*      elapsed   = &src.profile.ingestMs;
+
+            src.future = QtConcurrent::run([unchanged, stale, elapsed]() -> QString {
+                QElapsedTimer timer;
+                timer.start();
+
+                try
+                {
+                    *stale = !unchanged();
+                } catch (const std::exception& e)
+                {
+                    return QString(e.what());
+                }
+
+                *elapsed = timer.nsecsElapsed() / 1e6;
+
+                return QString();
+            });
+        }
+        else if (src.stream)
+        {
+            stream_fn                    ingest  = src.streamIngest;
+            std::shared_ptr<ChunkStream> stream  = src.stream;
+            double*                      elapsed = &src.profile.ingestMs;
+
+            src.future = QtConcurrent::run(&m_streamPool, [ingest, stream, elapsed]() -> QString {
+                QElapsedTimer timer;
+                timer.start();
+
+                try
+                {
+                    ingest(*stream);
+                } catch (const std::exception& e)
+                {
+                    return QString(e.what());
+                }
+
+                *elapsed = timer.nsecsElapsed() / 1e6;
+
+                return QString();
+            });
+        }
+        else
+        {
+            ingest_fn  ingest  = src.ingest;
+            QByteArray payload = src.payload;
+            double*    elapsed = &src.profile.ingestMs;
+
+            src.future = QtConcurrent::run([ingest, payload, elapsed]() -> QString {
+                QElapsedTimer timer;
+                timer.start();
+
+                try
+                {
+                    ingest(payload);
+                } catch (const std::exception& e)
+                {
+                    return QString(e.what());
+                }
+
+                *elapsed = timer.nsecsElapsed() / 1e6;
+
+                return QString();
+            });
+        }
+
+        watcher->setFuture(src.future);
+    }
+}
+
+void DataLoader::fail(const QString& msg)
+{
+    if (m_failed)
+    {
+        return;
+    }
+
+    m_failed = true;
+    m_error  = msg;
+
+    qWarning() << msg;
+
+    for (auto& src : m_sources)
+    {
+        if (src.stream)
+        {
+            src.stream->abort();
+        }
+
+        if (src.reply)
+        {
+            src.reply->abort();
+        }
+    }
+
+    // Ingest functions write into caller owned tables so none
+    // of them may outlive this call
+    for (auto& src : m_sources)
+    {
+        if (src.state == load_state::ingesting)
+        {
+            src.future.waitForFinished();
+        }
+    }
+
+    emit finished();
+}
+
+bool DataLoader::ready(const Source& src) const
+{
+    // Streamed datasets are ingested while they are still downloading, but only
+    // once the body has started so a 304 never reaches the parser
+    if (src.stream && !src.notModified)
+    {
+        return ((src.state == load_state::fetching && src.received > 0) || src.state == load_state::fetched);
+    }
+
+    return (src.state == load_state::fetched);
+}
+
+bool DataLoader::depsDone(const Source& src) const
+{
+    for (const auto& dep : src.deps)
+    {
+        auto it = std::find_if(m_sources.begin(), m_sources.end(), [&](const Source& s) { return s.name == dep; });
+
+        if (it == m_sources.end() || it->state != load_state::done)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const DataLoader::Source* DataLoader::find(const QString& name) const
+{
+    auto it = std::find_if(m_sources.begin(), m_sources.end(), [&](const Source& s) { return s.name == name; });
+    return (it != m_sources.end() ? &*it : nullptr);
+}
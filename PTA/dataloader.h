@@ -0,0 +1,150 @@
+#pragma once
+
+#include "chunkstream.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QUrl>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+// Fetches every registered dataset at once and hands each payload to its ingest
+// function on a worker thread as soon as it arrives. Datasets only wait for the
+// datasets they explicitly depend on.
+class DataLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Runs on a worker thread. Throw to report a failure.
+    using ingest_fn = std::function<void(const QByteArray&)>;
+    using stream_fn = std::function<void(ChunkStream&)>;
+
+    // Runs on a worker thread when the server reports a dataset as unchanged. Returns
+    // false if the previous copy cannot be reused, the dataset is then fetched in full.
+    using unchanged_fn = std::function<bool()>;
+
+    // Where the bytes of a dataset came from
+    enum class origin : uint8_t
+    {
+        local_file = 0,
+        network,
+        not_modified
+    };
+
+    struct Profile
+    {
+        origin source   = origin::network;
+        qint64 bytes    = 0;
+        double fetchMs  = 0; // until the whole body is in
+        double ingestMs = 0; // spent in the ingest function
+        double totalMs  = 0; // until ingested
+    };
+
+    DataLoader(QNetworkAccessManager* netmanager, QObject* parent = nullptr);
+
+    // Remote dataset
+    void add(const QString& name, const QUrl& url, ingest_fn ingest, const QStringList& deps = {});
+
+    // Local dataset with a remote fallback
+    void add(const QString& name, const QString& file, const QUrl& url, ingest_fn ingest, const QStringList& deps = {});
+
+    // Remote dataset that is parsed while it downloads. The ingest function
+    // starts as soon as its dependencies are done and reads the body as it arrives.
+    void addStream(const QString& name, const QUrl& url, stream_fn ingest, const QStringList& deps = {});
+
+    // Sends a conditional request for a remote dataset using the validators of the
+    // copy the caller already has. A 304, or a full response with the same ETag, runs
+    // unchanged instead of the ingest function, before any of the body is read
+    void revalidate(const QString& name, const QByteArray& etag, const QByteArray& lastModified, unchanged_fn unchanged);
+
+    // Validators of the response a dataset was loaded from, empty for local files
+    QByteArray etag(const QString& name) const;
+    QByteArray lastModified(const QString& name) const;
+
+    Profile profile(const QString& name) const;
+
+    // Starts loading and returns right away. finished() is emitted once every dataset
+    // is ingested or one fails
+    void start();
+
+    // Stops loading and waits for running ingest functions to return
+    void abort();
+
+    bool    failed() const { return m_failed; }
+    QString errorString() const { return m_error; }
+
+signals:
+    void datasetLoaded(const QString& name);
+    void finished();
+
+private:
+    enum class load_state : uint8_t
+    {
+        pending = 0,
+        fetching,
+        fetched,
+        ingesting,
+        done
+    };
+
+    struct Source
+    {
+        QString      name;
+        QString      file;
+        QUrl         url;
+        ingest_fn    ingest;
+        stream_fn    streamIngest;
+        unchanged_fn unchanged;
+        QStringList  deps;
+
+        QByteArray etag;
+        QByteArray lastModified;
+        bool       notModified = false;
+        bool       stale       = false;
+
+        QByteArray                   payload;
+        std::shared_ptr<ChunkStream> stream;
+        qint64                       received = 0;
+        QNetworkReply*               reply    = nullptr;
+        QFuture<QString>             future;
+        load_state                   state = load_state::pending;
+
+        QElapsedTimer timer;
+        Profile       profile;
+    };
+
+    void fetch(size_t idx);
+    void handleReply(size_t idx, QNetworkReply* reply);
+    void notModified(size_t idx);
+    void schedule();
+    void fail(const QString& msg);
+
+    bool sameDocument(const Source& src, QNetworkReply* reply) const;
+    bool depsDone(const Source& src) const;
+    bool ready(const Source& src) const;
+
+    const Source* find(const QString& name) const;
+
+private:
+    QNetworkAccessManager* m_manager;
+
+    std::vector<Source> m_sources;
+    size_t              m_done = 0;
+
+    // Streaming ingests block on the network, keep them off the global pool
+    QThreadPool m_streamPool;
+
+    bool    m_failed = false;
+    QString m_error;
+};
@@ -0,0 +1,777 @@
+#include "dataset.h"
+
+#include <functional>
+
+const std::array<const char*, table_max> Dataset::table_names = {"leagues",
+                                                                 "excludes",
+                                                                 "stats",
+                                                                 "uniques",
+                                                                 "base categories",
+                                                                 "item bases",
+                                                                 "mod types",
+                                                                 "pseudo rules",
+                                                                 "enchant rules",
+                                                                 "weapon local rules",
+                                                                 "armour local rules",
+                                                                 "discriminator rules",
+                                                                 "currency rules"};
+
+namespace
+{
+    // Picks a few string fields out of every object one level below the root of a
+    // RePoE document, e.g. {"Metadata/...": {"name": ..., "implicits": [...], ...}, ...}.
+    // Everything else is skipped without being materialized.
+    class RePoEEntrySax : public json::json_sax_t
+    {
+    public:
+        using fields_t   = std::unordered_map<std::string, std::string>;
+        using callback_t = std::function<void(const fields_t& fields, size_t counted)>;
+
+        RePoEEntrySax(std::initializer_list<std::string> wanted, std::string counted, callback_t cb) :
+            m_counted(std::move(counted)),
+            m_cb(std::move(cb))
+        {
+            for (const auto& w : wanted)
+            {
+                m_fields[w];
+            }
+        }
+
+        bool null() override { return true; }
+        bool boolean(bool) override { return true; }
+        bool number_integer(number_integer_t) override { return true; }
+        bool number_unsigned(number_unsigned_t) override { return true; }
+        bool number_float(number_float_t, const string_t&) override { return true; }
+
+        bool string(string_t& val) override
+        {
+            if (m_depth == entry_depth)
+            {
+                auto it = m_fields.find(m_key);
+                if (it != m_fields.end())
+                {
+                    it->second = std::move(val);
+                }
+            }
+            else if (m_depth == entry_depth + 1 && m_counting)
+            {
+                m_count++;
+            }
+
+            return true;
+        }
+
+        bool start_object(std::size_t) override
+        {
+            m_depth++;
+            return true;
+        }
+
+        bool key(string_t& val) override
+        {
+            if (m_depth == entry_depth)
+            {
+                m_key = std::move(val);
+            }
+
+            return true;
+        }
+
+        bool end_object() override
+        {
+            if (m_depth == entry_depth)
+            {
+                m_cb(m_fields, m_count);
+
+                for (auto& [k, v] : m_fields)
+                {
+                    v.clear();
+                }
+
+                m_count = 0;
+            }
+
+            m_depth--;
+            return true;
+        }
+
+        bool start_array(std::size_t) override
+        {
+            if (m_depth == entry_depth)
+            {
+                m_counting = (m_key == m_counted);
+            }
+
+            m_depth++;
+            return true;
+        }
+
+        bool end_array() override
+        {
+            m_depth--;
+
+            if (m_depth == entry_depth)
+            {
+                m_counting = false;
+            }
+
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override
+        {
+            throw std::runtime_error(ex.what());
+        }
+
+    private:
+        static constexpr size_t entry_depth = 2;
+
+        fields_t    m_fields;
+        std::string m_counted;
+        callback_t  m_cb;
+
+        std::string m_key;
+        size_t      m_depth    = 0;
+        size_t      m_count    = 0;
+        bool        m_counting = false;
+    };
+}
+
+dataset_table Dataset::dependency(dataset_table table)
+{
+    switch (table)
+    {
+        case table_stats:
+            return table_excludes;
+        case table_bases:
+            return table_base_categories;
+        case table_pseudo_rules:
+        case table_enchant_rules:
+        case table_weapon_locals:
+        case table_armour_locals:
+        case table_discriminators:
+            return table_stats;
+        default:
+            return table_max;
+    }
+}
+
+uint64_t Dataset::fingerprint(dataset_table table, uint64_t content, uint64_t dephash)
+{
+    const uint64_t parts[] = {table, content, dephash};
+
+    return ptadb::hash(reinterpret_cast<const char*>(parts), sizeof(parts));
+}
+
+void Dataset::addMod(AffixTable& mods, const std::string& name, const std::string& generation)
+{
+    if (name.empty())
+    {
+        // Skip the mods with no name
+        return;
+    }
+
+    mod_generation_type type = mod_generation_type::mod_unknown;
+
+    if (generation == "prefix")
+    {
+        type = mod_generation_type::mod_prefix;
+    }
+    else if (generation == "suffix")
+    {
+        type = mod_generation_type::mod_suffix;
+    }
+
+    if (type == mod_generation_type::mod_unknown)
+    {
+        // We only care about magic mods for now here so
+        // skip all other mod types like corrupted/unique mods
+        return;
+    }
+
+    mods.add(name, type);
+}
+
+void Dataset::compilePseudoRules(const json& rules)
+{
+    const StatTable& st      = stats();
+    auto             pseudos = std::make_shared<PseudoTable>();
+
+    for (const auto& [id, list] : rules.items())
+    {
+        StatTable::index_t stat = st.find(id);
+
+        if (stat == StatTable::npos)
+        {
+            continue;
+        }
+
+        for (const auto& r : list)
+        {
+            StatTable::index_t pseudo = st.find(r["id"].get<std::string>());
+
+            if (pseudo == StatTable::npos)
+            {
+                continue;
+            }
+
+            pseudos->add(stat, pseudo, r["factor"].get<double>(), (r.value("op", "") == "add"));
+        }
+    }
+
+    pseudos->seal(st.size());
+    put<PseudoTable>(table_pseudo_rules, pseudos);
+}
+
+void Dataset::compileEnchantRules(const json& rules)
+{
+    const StatTable& st       = stats();
+    auto             enchants = std::make_shared<EnchantTable>();
+
+    for (const auto& [text, r] : rules.items())
+    {
+        EnchantTable::rule rule;
+
+        if (r.contains("id"))
+        {
+            rule.stat = st.find(r["id"].get<std::string>());
+        }
+
+        if (r.contains("value"))
+        {
+            rule.hasValue = true;
+            rule.real     = r["value"].is_number_float();
+            rule.value    = r["value"].get<double>();
+        }
+
+        enchants->add(st, text, rule);
+    }
+
+    enchants->seal();
+    put<EnchantTable>(table_enchant_rules, enchants);
+}
+
+void Dataset::compileLocals(dataset_table t, const json& texts)
+{
+    auto locals = std::make_shared<LocalTable>();
+
+    for (const auto& text : texts)
+    {
+        locals->add(stats(), text.get<std::string>());
+    }
+
+    locals->seal();
+    put<LocalTable>(t, locals);
+}
+
+void Dataset::compileDiscriminators(const json& rules)
+{
+    const StatTable& st            = stats();
+    auto             discriminated = std::make_shared<DiscriminatorTable>();
+
+    for (const auto& [id, list] : rules.items())
+    {
+        StatTable::index_t stat = st.find(id);
+
+        if (stat == StatTable::npos)
+        {
+            continue;
+        }
+
+        for (const auto& cat : list["unused"])
+        {
+            discriminated->add(stat, cat.get<std::string>());
+        }
+    }
+
+    discriminated->seal(st.size());
+    put<DiscriminatorTable>(table_discriminators, discriminated);
+}
+
+void Dataset::build(dataset_table table, const json& data)
+{
+    switch (table)
+    {
+        case table_leagues:
+        {
+            auto& lgs     = data["result"];
+            auto  leagues = std::make_shared<json>(json::array());
+
+            for (size_t i = 0; i < lgs.size(); i++)
+            {
+                leagues->push_back(lgs[i]["id"].get<std::string>());
+            }
+
+            put<json>(table, leagues);
+            break;
+        }
+
+        case table_excludes:
+        {
+            auto excludes = std::make_shared<std::unordered_set<std::string>>();
+
+            for (const auto& e : data["excludes"])
+            {
+                excludes->insert(e.get<std::string>());
+            }
+
+            put<std::unordered_set<std::string>>(table, excludes);
+            break;
+        }
+
+        case table_stats:
+        {
+            const auto& ex    = excludes();
+            auto        stats = std::make_shared<StatTable>();
+
+            for (const auto& type : data["result"])
+            {
+                for (const auto& et : type["entries"])
+                {
+                    std::string id = et["id"].get<std::string>();
+
+                    if (!ex.contains(id))
+                    {
+                        stats->add(id, et["text"].get<std::string>(), et["type"].get<std::string>());
+                    }
+                }
+            }
+
+            stats->seal();
+            put<StatTable>(table, stats);
+            break;
+        }
+
+        case table_uniques:
+        {
+            auto uniques = std::make_shared<UniqueTable>();
+
+            for (const auto& type : data["result"])
+            {
+                for (const auto& et : type["entries"])
+                {
+                    // Only keep what the price checks look at
+                    uint8_t fields = (et.contains("name") ? UniqueTable::field_name : 0) | (et.contains("type") ? UniqueTable::field_type : 0) |
+                                     (et.contains("disc") ? UniqueTable::field_disc : 0);
+
+                    if (fields & (UniqueTable::field_name | UniqueTable::field_type))
+                    {
+                        uniques->add(et.value("name", ""), et.value("type", ""), et.value("disc", ""), fields);
+                    }
+                }
+            }
+
+            uniques->seal();
+            put<UniqueTable>(table, uniques);
+            break;
+        }
+
+        case table_base_categories:
+        {
+            auto baseCat = std::make_shared<std::map<std::string, std::string>>();
+
+            for (const auto& [k, v] : data.items())
+            {
+                baseCat->insert({k, v.get<std::string>()});
+            }
+
+            put<std::map<std::string, std::string>>(table, baseCat);
+            break;
+        }
+
+        case table_bases:
+        {
+            const auto& cats  = baseCat();
+            auto        bases = std::make_shared<BaseTable>();
+
+            for (const auto& [k, o] : data.items())
+            {
+                auto search = cats.find(o["item_class"].get<std::string>());
+                if (search != cats.end())
+                {
+                    bases->add(o["name"].get<std::string>(), search->second, static_cast<uint32_t>(o["implicits"].size()));
+                }
+            }
+
+            bases->seal();
+            put<BaseTable>(table, bases);
+            break;
+        }
+
+        case table_mods:
+        {
+            auto mods = std::make_shared<AffixTable>();
+
+            for (const auto& [k, o] : data.items())
+            {
+                addMod(*mods, o["name"].get<std::string>(), o["generation_type"].get<std::string>());
+            }
+
+            mods->seal();
+            put<AffixTable>(table, mods);
+            break;
+        }
+
+        case table_pseudo_rules:
+        {
+            compilePseudoRules(data);
+            break;
+        }
+
+        case table_enchant_rules:
+        {
+            compileEnchantRules(data);
+            break;
+        }
+
+        case table_weapon_locals:
+        case table_armour_locals:
+        {
+            compileLocals(table, data["data"]);
+            break;
+        }
+
+        case table_discriminators:
+        {
+            compileDiscriminators(data);
+            break;
+        }
+
+        case table_currency:
+        {
+            auto currencies = std::make_shared<CurrencyTable>();
+
+            for (const auto& [name, code] : data.items())
+            {
+                currencies->add(name, code.get<std::string>());
+            }
+
+            currencies->seal();
+            put<CurrencyTable>(table, currencies);
+            break;
+        }
+
+        case table_max:
+        {
+            break;
+        }
+    }
+}
+
+void Dataset::build(dataset_table table, std::istream& in)
+{
+    switch (table)
+    {
+        case table_bases:
+        {
+            const auto& cats  = baseCat();
+            auto        bases = std::make_shared<BaseTable>();
+
+            RePoEEntrySax sax({"name", "item_class"}, "implicits", [&](const auto& fields, size_t implicits) {
+                auto search = cats.find(fields.at("item_class"));
+                if (search != cats.end())
+                {
+                    bases->add(fields.at("name"), search->second, static_cast<uint32_t>(implicits));
+                }
+            });
+
+            json::sax_parse(in, &sax);
+            bases->seal();
+            put<BaseTable>(table, bases);
+            break;
+        }
+
+        case table_mods:
+        {
+            auto mods = std::make_shared<AffixTable>();
+
+            RePoEEntrySax sax({"name", "generation_type"}, std::string(), [&](const auto& fields, size_t) {
+                addMod(*mods, fields.at("name"), fields.at("generation_type"));
+            });
+
+            json::sax_parse(in, &sax);
+            mods->seal();
+            put<AffixTable>(table, mods);
+            break;
+        }
+
+        default:
+        {
+            build(table, json::parse(in));
+            break;
+        }
+    }
+}
+
+void Dataset::save(dataset_table table, ptadb::Writer& out, uint64_t hash) const
+{
+    ptadb::SectionWriter s;
+
+    switch (table)
+    {
+        case table_leagues:
+        {
+            s.u32(static_cast<uint32_t>(leagues().size()));
+
+            for (const auto& l : leagues())
+            {
+                s.str(l.get<std::string>());
+            }
+
+            break;
+        }
+
+        case table_excludes:
+        {
+            s.u32(static_cast<uint32_t>(excludes().size()));
+
+            for (const auto& e : excludes())
+            {
+                s.str(e);
+            }
+
+            break;
+        }
+
+        case table_stats:
+            stats().save(s);
+            break;
+        case table_uniques:
+            uniques().save(s);
+            break;
+
+        case table_base_categories:
+        {
+            s.u32(static_cast<uint32_t>(baseCat().size()));
+
+            for (const auto& [k, v] : baseCat())
+            {
+                s.str(k);
+                s.str(v);
+            }
+
+            break;
+        }
+
+        case table_bases:
+            bases().save(s);
+            break;
+        case table_mods:
+            mods().save(s);
+            break;
+        case table_pseudo_rules:
+            pseudos().save(s);
+            break;
+        case table_enchant_rules:
+            enchants().save(s);
+            break;
+        case table_weapon_locals:
+            localWeaponStats().save(s);
+            break;
+        case table_armour_locals:
+            localArmourStats().save(s);
+            break;
+        case table_discriminators:
+            discriminated().save(s);
+            break;
+        case table_currency:
+            currencies().save(s);
+            break;
+        case table_max:
+            break;
+    }
+
+    out.add(table, hash, s);
+}
+
+namespace
+{
+    // A table that views its arrays in a snapshot, and what keeps the snapshot data around
+    template <typename T>
+    struct mapped_table
+    {
+        std::shared_ptr<const void> backing;
+        T                           table;
+    };
+}
+
+template <typename T>
+bool Dataset::restoreTable(dataset_table t, ptadb::SectionReader& s, const std::shared_ptr<const void>& backing)
+{
+    auto mapped = std::make_shared<mapped_table<T>>();
+
+    if (!mapped->table.restore(s))
+    {
+        return false;
+    }
+
+    mapped->backing = backing;
+
+    // Points at the table, owns the table and the backing
+    put<T>(t, std::shared_ptr<const T>(mapped, &mapped->table));
+    return true;
+}
+
+bool Dataset::restore(dataset_table table, const ptadb::Reader& in)
+{
+    ptadb::SectionReader s = in.section(table);
+
+    if (!s.valid())
+    {
+        return false;
+    }
+
+    clear(table);
+
+    uint32_t         count = 0;
+    std::string_view a, b;
+
+    // The small lookups of the build are copied out, the sealed tables are viewed in place
+    switch (table)
+    {
+        case table_leagues:
+        {
+            auto leagues = std::make_shared<json>(json::array());
+
+            s.u32(count);
+            for (uint32_t i = 0; i < count && s.str(a); i++)
+            {
+                leagues->push_back(std::string(a));
+            }
+
+            put<json>(table, leagues);
+            break;
+        }
+
+        case table_excludes:
+        {
+            auto excludes = std::make_shared<std::unordered_set<std::string>>();
+
+            s.u32(count);
+            for (uint32_t i = 0; i < count && s.str(a); i++)
+            {
+                excludes->emplace(a);
+            }
+
+            put<std::unordered_set<std::string>>(table, excludes);
+            break;
+        }
+
+        case table_stats:
+            restoreTable<StatTable>(table, s, in.backing());
+            break;
+        case table_uniques:
+            restoreTable<UniqueTable>(table, s, in.backing());
+            break;
+
+        case table_base_categories:
+        {
+            auto baseCat = std::make_shared<std::map<std::string, std::string>>();
+
+            s.u32(count);
+            for (uint32_t i = 0; i < count && s.str(a) && s.str(b); i++)
+            {
+                baseCat->emplace(a, b);
+            }
+
+            put<std::map<std::string, std::string>>(table, baseCat);
+            break;
+        }
+
+        case table_bases:
+            restoreTable<BaseTable>(table, s, in.backing());
+            break;
+        case table_mods:
+            restoreTable<AffixTable>(table, s, in.backing());
+            break;
+        case table_pseudo_rules:
+            restoreTable<PseudoTable>(table, s, in.backing());
+            break;
+        case table_enchant_rules:
+            restoreTable<EnchantTable>(table, s, in.backing());
+            break;
+        case table_weapon_locals:
+        case table_armour_locals:
+            restoreTable<LocalTable>(table, s, in.backing());
+            break;
+        case table_discriminators:
+            restoreTable<DiscriminatorTable>(table, s, in.backing());
+            break;
+        case table_currency:
+            restoreTable<CurrencyTable>(table, s, in.backing());
+            break;
+        case table_max:
+            break;
+    }
+
+    // Never leave a half built table behind from a truncated or corrupt section
+    if (!s.valid() || !s.atEnd() || !has(table))
+    {
+        clear(table);
+        return false;
+    }
+
+    return true;
+}
+
+void Dataset::clear(dataset_table table)
+{
+    if (table < table_max)
+    {
+        m_tables[table].reset();
+        fingerprints[table] = 0;
+    }
+}
+
+void Dataset::share(dataset_table table, const Dataset& from)
+{
+    m_tables[table]     = from.m_tables[table];
+    fingerprints[table] = from.fingerprints[table];
+}
+
+uint32_t Dataset::loaded() const
+{
+    uint32_t mask = 0;
+
+    for (uint32_t t = 0; t < table_max; t++)
+    {
+        mask |= (m_tables[t] ? (1u << t) : 0);
+    }
+
+    return mask;
+}
+
+size_t Dataset::size(dataset_table table) const
+{
+    switch (table)
+    {
+        case table_leagues:
+            return leagues().size();
+        case table_excludes:
+            return excludes().size();
+        case table_stats:
+            return stats().size();
+        case table_uniques:
+            return uniques().size();
+        case table_base_categories:
+            return baseCat().size();
+        case table_bases:
+            return bases().size();
+        case table_mods:
+            return mods().size();
+        case table_pseudo_rules:
+            return pseudos().size();
+        case table_enchant_rules:
+            return enchants().size();
+        case table_weapon_locals:
+            return localWeaponStats().size();
+        case table_armour_locals:
+            return localArmourStats().size();
+        case table_discriminators:
+            return discriminated().size();
+        case table_currency:
+            return currencies().size();
+        default:
+            return 0;
+    }
+}
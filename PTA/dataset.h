@@ -0,0 +1,136 @@
+#pragma once
+
+#include "itemtables.h"
+#include "pseudotable.h"
+#include "ptadb.h"
+#include "statrules.h"
+#include "stattable.h"
+
+#include <array>
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// One table per source document
+enum dataset_table : uint32_t
+{
+    table_leagues = 0,
+    table_excludes,
+    table_stats, // depends on table_excludes
+    table_uniques,
+    table_base_categories,
+    table_bases, // depends on table_base_categories
+    table_mods,
+    table_pseudo_rules,   // depends on table_stats
+    table_enchant_rules,  // depends on table_stats
+    table_weapon_locals,  // depends on table_stats
+    table_armour_locals,  // depends on table_stats
+    table_discriminators, // depends on table_stats
+    table_currency,
+    table_max
+};
+
+// The game and rule data that items are parsed and priced against.
+//
+// Each table is built from a single source document and can be saved to and
+// restored from a .ptadb snapshot on its own, so a table only has to be rebuilt
+// from JSON when its source (or a table it depends on) actually changes. A
+// table is saved once it is sealed, and a restored table reads its arrays in
+// place from the snapshot and keeps the snapshot data alive for as long as it
+// does. The rule tables are compiled against the stat table and refer to stats
+// by index, which is why they depend on it.
+//
+// Tables are immutable once they are in and shared by every generation they are
+// unchanged in, so a dataset is cheap to copy. A table that is not in reads as
+// an empty one.
+class Dataset
+{
+public:
+    static const std::array<const char*, table_max> table_names;
+
+    void build(dataset_table table, const json& data);
+
+    // Streaming build straight off the wire without a JSON DOM. Only
+    // supported by the large RePoE tables, see streamable()
+    void build(dataset_table table, std::istream& in);
+
+    static bool streamable(dataset_table table) { return (table == table_bases || table == table_mods); }
+
+    // The table that has to be built before this one, table_max if none
+    static dataset_table dependency(dataset_table table);
+
+    void save(dataset_table table, ptadb::Writer& out, uint64_t hash) const;
+    bool restore(dataset_table table, const ptadb::Reader& in);
+    void clear(dataset_table table);
+
+    // Takes over a table of another dataset with its fingerprint, without copying it
+    void share(dataset_table table, const Dataset& from);
+
+    bool has(dataset_table table) const { return static_cast<bool>(m_tables[table]); }
+
+    // Bit per table that is in
+    uint32_t loaded() const;
+
+    // Number of entries in a table
+    size_t size(dataset_table table) const;
+
+    // Source fingerprint of a table from the hash of its source document
+    // and the fingerprint of the table it depends on
+    static uint64_t fingerprint(dataset_table table, uint64_t content, uint64_t dephash = 0);
+
+    const json&                               leagues() const { return get<json>(table_leagues); }
+    const std::unordered_set<std::string>&    excludes() const { return get<std::unordered_set<std::string>>(table_excludes); }
+    const StatTable&                          stats() const { return get<StatTable>(table_stats); }
+    const UniqueTable&                        uniques() const { return get<UniqueTable>(table_uniques); }
+    const std::map<std::string, std::string>& baseCat() const { return get<std::map<std::string, std::string>>(table_base_categories); }
+    const BaseTable&                          bases() const { return get<BaseTable>(table_bases); }
+    const AffixTable&                         mods() const { return get<AffixTable>(table_mods); }
+    const PseudoTable&                        pseudos() const { return get<PseudoTable>(table_pseudo_rules); }
+    const EnchantTable&                       enchants() const { return get<EnchantTable>(table_enchant_rules); }
+    const LocalTable&                         localWeaponStats() const { return get<LocalTable>(table_weapon_locals); }
+    const LocalTable&                         localArmourStats() const { return get<LocalTable>(table_armour_locals); }
+    const DiscriminatorTable&                 discriminated() const { return get<DiscriminatorTable>(table_discriminators); }
+    const CurrencyTable&                      currencies() const { return get<CurrencyTable>(table_currency); }
+
+public:
+    // Bumped every time a refreshed dataset replaces the current one
+    uint64_t generation = 0;
+
+    // Source fingerprint of every table, 0 until the table is in
+    std::array<uint64_t, table_max> fingerprints = {};
+
+private:
+    template <typename T>
+    const T& get(dataset_table t) const
+    {
+        static const T empty;
+
+        return (m_tables[t] ? *static_cast<const T*>(m_tables[t].get()) : empty);
+    }
+
+    template <typename T>
+    void put(dataset_table t, std::shared_ptr<const T> table)
+    {
+        m_tables[t] = std::move(table);
+    }
+
+    template <typename T>
+    bool restoreTable(dataset_table t, ptadb::SectionReader& s, const std::shared_ptr<const void>& backing);
+
+    static void addMod(AffixTable& mods, const std::string& name, const std::string& generation);
+    void compilePseudoRules(const json& rules);
+    void compileEnchantRules(const json& rules);
+    void compileLocals(dataset_table t, const json& texts);
+    void compileDiscriminators(const json& rules);
+
+private:
+    // The table of every dataset_table, null until it is in. Restored tables also
+    // hold on to the snapshot data they view
+    std::array<std::shared_ptr<const void>, table_max> m_tables;
+};
@@ -1,23 +1,40 @@
 #include "itemapi.h"
+#include "alloccount.h"
+#include "dataloader.h"
+#include "dataset.h"
 #include "pitem.h"
+#include "propscan.h"
 #include "pta_types.h"
 
-#include <regex>
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <numeric>
 #include <string>
 
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QDesktopServices>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QEventLoop>
 #include <QFileInfo>
 #include <QNetworkReply>
 #include <QRegularExpression>
+#include <QSaveFile>
 #include <QSettings>
+#include <QStandardPaths>
+#include <QtConcurrent>
 #include <QUrl>
 
 // PoE trade api only allows 10 items at once
 constexpr size_t papi_query_limit = 10;
 
+// How often the datasets are revalidated for new league content
+constexpr int dataset_refresh_interval = 60 * 60 * 1000;
+
 // API URLs
 
 // official
@@ -49,674 +66,1240 @@ const QString u_poewiki("https://pathofexile.gamepedia.com/");
 // poe prices
 const QString u_poeprices("https://www.poeprices.info/api?l=%1&i=%2");
 
-ItemAPI::ItemAPI(QNetworkAccessManager* netmanager, QObject* parent) : QObject(parent), m_manager(netmanager)
+namespace
 {
-    json data;
+    // Snapshots are named by the time they were written. Restored tables read theirs in
+    // place, so a new snapshot never replaces one that may still be mapped but is written
+    // next to it, and the older ones are removed once nothing maps them any more
+    QString snapshotDir()
+    {
+        return QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    }
+
+    QString latestSnapshot()
+    {
+        QStringList names = QDir(snapshotDir()).entryList({"dataset-*.ptadb"}, QDir::Files, QDir::Name);
 
-    ///////////////////////////////////////////// Download leagues
+        return (names.isEmpty() ? QString() : snapshotDir() + "/" + names.last());
+    }
+
+    // Snapshot compiled by ptadbc and shipped with the app, served until there is one in the cache
+    QString bundledSnapshot()
+    {
+        return QCoreApplication::applicationDirPath() + "/data.ptadb";
+    }
+
+    QString newSnapshotPath()
+    {
+        return snapshotDir() + QString("/dataset-%1.ptadb").arg(QDateTime::currentMSecsSinceEpoch(), 16, 10, QChar('0'));
+    }
 
-    if (!synchronizedGetJSON(QNetworkRequest(u_api_league), data))
+    // A snapshot that is still mapped cannot be removed on every platform, that one is
+    // left for a later write to clean up
+    void removeOldSnapshots(const QString& keep)
     {
-        throw std::runtime_error("Failed to download league data");
+        QDir dir(snapshotDir());
+
+        for (const auto& name : dir.entryList({"dataset*.ptadb"}, QDir::Files))
+        {
+            if (name != QFileInfo(keep).fileName())
+            {
+                dir.remove(name);
+            }
+        }
     }
 
-    auto& lgs = data["result"];
+    QString startupReportPath()
+    {
+        return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/startup_profile.json";
+    }
 
-    m_leagues = json::array();
-    for (size_t i = 0; i < lgs.size(); i++)
+    QString parseCachePath()
     {
-        m_leagues.push_back(lgs[i]["id"].get<std::string>());
+        return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/parsecache.json";
     }
 
-    QString setlg = getLeague();
+    // Snapshot section holding the HTTP validators of every remote dataset. Kept out of
+    // the dataset_table id range.
+    constexpr uint32_t manifest_section = 0x1000;
 
-    qInfo() << "League data loaded. Setting league to" << setlg;
+    struct manifest_entry
+    {
+        std::string etag;
+        std::string lastModified;
+        uint64_t    content = 0; // hash of the document the validators belong to
 
-    ///////////////////////////////////////////// Load excludes (needs to be loaded BEFORE stats)
+        bool operator==(const manifest_entry&) const = default;
+    };
 
-    QFile excl("data/excludes.json");
+    // Keyed by URL
+    using manifest = std::unordered_map<std::string, manifest_entry>;
 
-    if (excl.open(QIODevice::ReadOnly))
+    manifest readManifest(const ptadb::Reader& in)
     {
-        QByteArray edat = excl.readAll();
+        manifest result;
+
+        if (!in.contains(manifest_section))
+        {
+            return result;
+        }
 
-        json excj = json::parse(edat.toStdString());
+        auto section = in.section(manifest_section);
 
-        for (const auto& e : excj["excludes"])
+        while (section.valid() && !section.atEnd())
         {
-            c_excludes.insert(e.get<std::string>());
+            std::string_view url, etag, lastModified;
+            uint64_t         content;
+
+            if (!section.str(url) || !section.str(etag) || !section.str(lastModified) || !section.u64(content))
+            {
+                return {};
+            }
+
+            result[std::string(url)] = {std::string(etag), std::string(lastModified), content};
         }
+
+        return result;
     }
-    else if (synchronizedGetJSON(QNetworkRequest(u_pta_excludes), data))
+
+    void writeManifest(const manifest& entries, ptadb::Writer& out)
     {
-        for (const auto& e : data["excludes"])
+        ptadb::SectionWriter section;
+
+        for (const auto& [url, e] : entries)
         {
-            c_excludes.insert(e.get<std::string>());
+            section.str(url);
+            section.str(e.etag);
+            section.str(e.lastModified);
+            section.u64(e.content);
         }
+
+        out.add(manifest_section, 0, section);
     }
-    else
+
+    // Saves every table of a load along with the validators of its sources as the newest snapshot
+    void writeSnapshot(const Dataset& data, const std::array<uint64_t, table_max>& hashes, const manifest& validators, int rebuilt)
     {
-        throw std::runtime_error("Cannot open excludes.json");
+        ptadb::Writer out;
+
+        for (uint32_t t = 0; t < table_max; t++)
+        {
+            data.save(static_cast<dataset_table>(t), out, hashes[t]);
+        }
+
+        writeManifest(validators, out);
+
+        std::string image = out.finish();
+        QString     path  = newSnapshotPath();
+
+        QDir().mkpath(snapshotDir());
+
+        QSaveFile sf(path);
+
+        if (sf.open(QIODevice::WriteOnly) && sf.write(image.data(), image.size()) == qint64(image.size()) && sf.commit())
+        {
+            qInfo() << "Dataset snapshot updated," << rebuilt << "table(s) rebuilt";
+
+            removeOldSnapshots(path);
+        }
+        else
+        {
+            qWarning() << "Failed to write dataset snapshot to" << path;
+        }
     }
 
-    qInfo() << "Exclude rules loaded";
+    struct source
+    {
+        dataset_table table;
+        QString       file;
+        QUrl          url;
+        data_tier     tier;
+    };
+
+    const std::vector<source> c_sources = {{table_leagues, QString(), u_api_league, tier_core},
+                                           {table_excludes, "data/excludes.json", u_pta_excludes, tier_stats},
+                                           {table_stats, QString(), u_api_stats, tier_stats},
+                                           {table_uniques, QString(), u_api_items, tier_stats},
+                                           {table_base_categories, "data/base_categories.json", u_pta_basecat, tier_bases},
+                                           {table_bases, QString(), u_repoe_base, tier_bases},
+                                           {table_mods, QString(), u_repoe_mods, tier_full},
+                                           {table_pseudo_rules, "data/pseudo_rules.json", u_pta_pseudorules, tier_stats},
+                                           {table_enchant_rules, "data/enchant_rules.json", u_pta_enchantrules, tier_stats},
+                                           {table_weapon_locals, "data/weapon_locals.json", u_pta_weaponlocals, tier_stats},
+                                           {table_armour_locals, "data/armour_locals.json", u_pta_armourlocals, tier_stats},
+                                           {table_discriminators, "data/discriminators.json", u_pta_disc, tier_stats},
+                                           {table_currency, "data/currency.json", u_pta_currency, tier_core}};
+
+    const std::array<const char*, tier_max> c_tierNames = {"core", "stats", "bases", "full"};
+
+    // Whether every table of a tier and the ones before it is in, loaded has a bit per dataset_table
+    bool tierLoaded(uint32_t loaded, data_tier tier)
+    {
+        return std::all_of(c_sources.begin(), c_sources.end(), [&](const source& src) { return (src.tier > tier || (loaded & (1u << src.table))); });
+    }
 
-    ///////////////////////////////////////////// Download stats
+    // Indexed by DataLoader::origin
+    const std::array<const char*, 3> c_originNames = {"file", "network", "not modified"};
 
-    if (!synchronizedGetJSON(QNetworkRequest(u_api_stats), data))
+    // Separates the mod kind from the tags in an advanced copy header
+    constexpr std::string_view em_dash = "\u2014";
+
+    // For the log, the parser itself never leaves UTF-8
+    QString qstr(std::string_view s)
+    {
+        return QString::fromUtf8(s.data(), static_cast<int>(s.size()));
+    }
+
+    // Rarities as the first line of the item text names them
+    constexpr auto c_rarities = perfect::make<item_rarity_e>({{"Normal", rarity_normal},
+                                                              {"Magic", rarity_magic},
+                                                              {"Rare", rarity_rare},
+                                                              {"Unique", rarity_unique},
+                                                              {"Gem", rarity_gem},
+                                                              {"Currency", rarity_currency},
+                                                              {"Divination Card", rarity_card},
+                                                              {"card", rarity_card},
+                                                              {"Quest", rarity_quest}});
+
+    item_rarity_e readRarity(std::string_view rarity)
     {
-        throw std::runtime_error("Failed to download stats data");
+        auto r = c_rarities.find(rarity);
+        return (r ? *r : rarity_unknown);
     }
 
-    auto& stt = data["result"];
+    // Lines that only flag the item
+    struct flag_line
+    {
+        uint32_t         fields;
+        item_influence_e influence; // influences_max for none
+    };
+
+    constexpr auto c_flagLines = perfect::make<flag_line>({{"Unidentified", {field_unidentified, influences_max}},
+                                                           {"Shaper Item", {0, influence_shaper}},
+                                                           {"Elder Item", {0, influence_elder}},
+                                                           {"Crusader Item", {0, influence_crusader}},
+                                                           {"Redeemer Item", {0, influence_redeemer}},
+                                                           {"Hunter Item", {0, influence_hunter}},
+                                                           {"Warlord Item", {0, influence_warlord}},
+                                                           {"Corrupted", {field_corrupted, influences_max}},
+                                                           {"Synthesised Item", {field_misc_synthesis, influences_max}}});
 
-    for (const auto& type : stt)
+    // Value of a "Name: value" line, up to a second ": " if there is one
+    std::string_view propValue(std::string_view line)
     {
-        auto& el = type["entries"];
+        size_t begin = line.find(": ");
 
-        for (const auto& et : el)
+        if (begin == std::string_view::npos)
         {
-            // Cut the key for multiline mods
-            std::string::size_type nl;
-            std::string            text = et["text"].get<std::string>();
-            std::string            id   = et["id"].get<std::string>();
+            return std::string_view();
+        }
 
-            if ((nl = text.find("\n")) != std::string::npos)
-            {
-                text = text.substr(0, nl);
-            }
+        std::string_view value = line.substr(begin + 2);
+
+        return value.substr(0, value.find(": "));
+    }
 
-            if (!c_excludes.contains(id))
+    // Copy of a name without the <<set:MS>> style markup and <tags> of the item text
+    std::string stripTags(std::string_view text)
+    {
+        std::string out;
+        out.reserve(text.size());
+
+        for (size_t pos = 0; pos < text.size();)
+        {
+            if (text[pos] == '<')
             {
-                m_stats_by_text.insert({{text, et}});
-                m_stats_by_id.insert({{id, et}});
+                size_t end = (text.substr(pos).starts_with("<<") ? text.find(">>", pos + 2) : std::string_view::npos);
+
+                if (end != std::string_view::npos)
+                {
+                    pos = end + 2;
+                    continue;
+                }
+
+                end = text.find('>', pos + 1);
+
+                if (end != std::string_view::npos)
+                {
+                    pos = end + 1;
+                    continue;
+                }
             }
+
+            out.push_back(text[pos++]);
         }
-    }
 
-    qInfo() << "Mod stats loaded";
+        return out;
+    }
 
-    ///////////////////////////////////////////// Download unique items
+    void eraseAll(std::string& s, std::string_view what)
+    {
+        for (size_t pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos))
+        {
+            s.erase(pos, what.size());
+        }
+    }
 
-    if (!synchronizedGetJSON(QNetworkRequest(u_api_items), data))
+    // Adds a number taken from a stat line, a float if it has a decimal point
+    void readNumeric(std::string_view token, ItemFilter& out)
     {
-        throw std::runtime_error("Failed to download unique item data");
+        if (!token.empty() && token[0] == '+')
+        {
+            token.remove_prefix(1);
+        }
+
+        const char* first = token.data();
+        const char* last  = token.data() + token.size();
+
+        if (token.find('.') != std::string_view::npos)
+        {
+            double val = 0.0;
+            std::from_chars(first, last, val);
+            out.push(val, true);
+            return;
+        }
+
+        int val = 0;
+        std::from_chars(first, last, val);
+        out.push(val, false);
     }
+}
 
-    auto& itm = data["result"];
+struct ItemAPI::Validators
+{
+    manifest entries;
+};
+
+// State of a background dataset load, only alive until every table is in
+struct ItemAPI::LoadState
+{
+    std::shared_ptr<Dataset>       data;    // tables of the load, only published once they are sealed
+    std::shared_ptr<const Dataset> base;    // generation a refresh started from, null on the first load
+    bool                           initial; // first load, tables are published as they come in
 
-    for (const auto& type : itm)
+    ptadb::Reader                   snapshot; // keeps the mapped file open, as do the tables restored from it
+    bool                            hasSnapshot = false;
+    manifest                        validators;
+    std::array<uint64_t, table_max> hashes   = {};
+    std::array<uint64_t, table_max> contents = {};
+    std::atomic_int                 restored = 0;
+    DataLoader*                     loader   = nullptr;
+    QFuture<bool>                   warm; // restore of a whole snapshot generation, see restoreSnapshot
+
+    // Startup profile
+    QElapsedTimer                 timer;
+    std::array<bool, table_max>   reused    = {}; // taken over from the current generation or the snapshot
+    std::array<double, table_max> restoreMs = {}; // warm start only
+    std::array<double, tier_max>  tierMs    = {};
+
+    // Whether a table with this fingerprint is already in the current generation
+    bool unchanged(dataset_table table, uint64_t hash) const { return (base && base->has(table) && base->fingerprints[table] == hash); }
+
+    // Whether a previous copy of the table may be around to reuse
+    bool reusable(dataset_table table) const { return (base ? base->has(table) : snapshot.contains(table)); }
+
+    // Takes the table over from the current generation if its fingerprint is the same,
+    // or else restores it from the snapshot. Returns false if it has to be built
+    bool reuse(dataset_table table, uint64_t hash)
     {
-        const auto& el = type["entries"];
+        if (unchanged(table, hash))
+        {
+            // Shared as it is, nothing is copied
+            data->share(table, *base);
+        }
+        else if (!hasSnapshot || snapshot.hash(table) != hash || !data->restore(table, snapshot))
+        {
+            return false;
+        }
+
+        hashes[table] = hash;
+        reused[table] = true;
+        restored++;
+
+        return true;
+    }
 
-        for (const auto& et : el)
+    // Whether any table differs from the ones of the current generation
+    bool changed() const
+    {
+        for (uint32_t t = 0; t < table_max; t++)
         {
-            if (et.contains("name"))
-            {
-                m_uniques.insert({{et["name"].get<std::string>(), et}});
-            }
-            else if (et.contains("type"))
-            {
-                m_uniques.insert({{et["type"].get<std::string>(), et}});
-            }
-            else
+            if (!unchanged(static_cast<dataset_table>(t), hashes[t]))
             {
-                qDebug() << "Item entry has neither name nor type:" << QString::fromStdString(et.dump());
+                return true;
             }
         }
+
+        return false;
     }
+};
 
-    qInfo() << "Unique item data loaded";
+ItemAPI::ItemAPI(QNetworkAccessManager* netmanager, QObject* parent) : QObject(parent), m_manager(netmanager)
+{
+    QSettings settings;
 
-    ///////////////////////////////////////////// Load base categories
+    if (settings.value(PTA_CONFIG_PERSIST_PARSE_CACHE, false).toBool())
+    {
+        m_parseCache.load(parseCachePath());
+    }
+
+    // Nothing is loaded yet, but there is always a generation to read
+    m_data.store(std::make_shared<const Dataset>());
+    m_validators = std::make_unique<Validators>();
+
+    startLoad();
+
+    // Pick up new league content without a restart
+    connect(&m_refreshTimer, &QTimer::timeout, this, &ItemAPI::refreshData);
+    m_refreshTimer.start(dataset_refresh_interval);
+}
+
+void ItemAPI::startLoad()
+{
+    m_load = std::make_unique<LoadState>();
+
+    LoadState* state = m_load.get();
+
+    state->data    = std::make_shared<Dataset>();
+    state->initial = (m_data.load()->generation == 0);
 
-    QFile bc("data/base_categories.json");
+    state->timer.start();
 
-    if (bc.open(QIODevice::ReadOnly))
+    if (!state->initial)
     {
-        QByteArray bdat = bc.readAll();
+        // A refresh takes the tables of unchanged sources over from the current generation,
+        // so neither the snapshot nor any table has to be read again
+        state->base       = m_data.load();
+        state->validators = m_validators->entries;
 
-        c_baseCat = json::parse(bdat.toStdString());
+        fetchSources();
+        return;
     }
-    else if (synchronizedGetJSON(QNetworkRequest(u_pta_basecat), data))
+
+    // Map the snapshot written by the previous run, or on a first run the one shipped with
+    // the app. Tables whose sources have not changed since are restored from it directly
+    // instead of being rebuilt from JSON, and read their arrays straight out of the mapping.
+    // The file stays open and mapped for as long as any of them is around.
+    QString path = latestSnapshot();
+
+    if (path.isEmpty() && QFileInfo::exists(bundledSnapshot()))
     {
-        c_baseCat = data;
+        path = bundledSnapshot();
     }
-    else
+
+    if (!path.isEmpty())
     {
-        throw std::runtime_error("Cannot open base_categories.json");
+        auto dbfile = std::make_shared<QFile>(path);
+
+        if (dbfile->open(QIODevice::ReadOnly))
+        {
+            const uchar* mem = dbfile->map(0, dbfile->size());
+
+            state->hasSnapshot = (mem && state->snapshot.open(reinterpret_cast<const char*>(mem), dbfile->size(), dbfile));
+        }
+
+        if (!state->hasSnapshot)
+        {
+            qInfo() << "Dataset snapshot is outdated or corrupt. Rebuilding.";
+        }
     }
 
-    qInfo() << "Base categories loaded";
+    if (state->hasSnapshot)
+    {
+        state->validators = readManifest(state->snapshot);
+    }
 
-    ///////////////////////////////////////////// Load RePoE base data (needs to be loaded AFTER c_baseCat)
+    // A warm start serves the generation the snapshot holds right away and only checks the
+    // sources for changes once it is up, instead of waiting on the network for every table
+    bool complete = state->hasSnapshot;
 
-    if (!synchronizedGetJSON(QNetworkRequest(u_repoe_base), data))
+    for (uint32_t t = 0; t < table_max && complete; t++)
     {
-        throw std::runtime_error("Failed to download base item data");
+        complete = state->snapshot.contains(t);
     }
 
-    for (const auto& [k, o] : data.items())
+    if (complete)
     {
-        std::string typeName  = o["name"].get<std::string>();
-        std::string itemClass = o["item_class"].get<std::string>();
-        size_t      implicits = o["implicits"].size();
+        restoreSnapshot();
+        return;
+    }
+
+    fetchSources();
+}
+
+void ItemAPI::restoreSnapshot()
+{
+    LoadState* state = m_load.get();
 
-        auto search = c_baseCat.find(itemClass);
-        if (search != c_baseCat.end())
+    auto watcher = new QFutureWatcher<bool>(this);
+
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+        handleSnapshotRestored(watcher->result());
+    });
+
+    state->warm = QtConcurrent::run([state]() -> bool {
+        // The tables are numbered in dependency order
+        for (uint32_t t = 0; t < table_max; t++)
         {
-            std::string itemCat = search.value().get<std::string>();
+            dataset_table table = static_cast<dataset_table>(t);
 
-            json cat;
+            QElapsedTimer timer;
+            timer.start();
 
-            cat["category"]  = itemCat;
-            cat["implicits"] = implicits;
+            try
+            {
+                if (!state->data->restore(table, state->snapshot))
+                {
+                    return false;
+                }
+            } catch (const std::exception& e)
+            {
+                qWarning() << "Failed to restore" << Dataset::table_names[t] << "from the snapshot:" << e.what();
+                return false;
+            }
 
-            c_baseMap.insert({{typeName, cat}});
+            state->hashes[t]    = state->snapshot.hash(t);
+            state->reused[t]    = true;
+            state->restoreMs[t] = timer.nsecsElapsed() / 1e6;
         }
-    }
 
-    qInfo() << "Item base data loaded";
+        return true;
+    });
+
+    watcher->setFuture(state->warm);
+}
 
-    ///////////////////////////////////////////// Load RePoE mod data
+void ItemAPI::handleSnapshotRestored(bool restored)
+{
+    LoadState* state = m_load.get();
 
-    if (!synchronizedGetJSON(QNetworkRequest(u_repoe_mods), data))
+    if (!restored)
     {
-        throw std::runtime_error("Failed to download mod type data");
+        // Nothing of it was published, start over from the sources
+        qInfo() << "Dataset snapshot could not be restored. Rebuilding.";
+
+        state->data      = std::make_shared<Dataset>();
+        state->hashes    = {};
+        state->reused    = {};
+        state->restoreMs = {};
+
+        fetchSources();
+        return;
     }
 
-    for (const auto& [k, o] : data.items())
+    state->restored = table_max;
+
+    publishTables((1u << table_max) - 1);
+
+    qInfo() << "Published the dataset snapshot, checking sources for updates";
+
+    reportStartup(*state);
+
+    m_validators->entries = state->validators;
+    m_load.reset();
+
+    // Runs as a refresh, a new generation is only published if anything changed
+    startLoad();
+}
+
+void ItemAPI::fetchSources()
+{
+    LoadState* state = m_load.get();
+
+    // Every dataset is requested at once and ingested on a worker thread as soon as it lands.
+    // Each table is built independently, so the only ordering required is the dependency list.
+    state->loader = new DataLoader(m_manager);
+
+    for (const auto& src : c_sources)
     {
-        std::string modname = o["name"].get<std::string>();
-        std::string modtype = o["generation_type"].get<std::string>();
+        QStringList   deps;
+        dataset_table dep = Dataset::dependency(src.table);
 
-        if (modname.empty())
+        if (dep != table_max)
         {
-            // Skip the mods with no name
-            continue;
+            deps << Dataset::table_names[dep];
         }
 
-        mod_generation_type type = mod_generation_type::mod_unknown;
-
-        if (modtype == "prefix")
+        if (Dataset::streamable(src.table) && src.file.isEmpty())
         {
-            type = mod_generation_type::mod_prefix;
+            // The RePoE documents are by far the largest, so they are parsed while they download.
+            // A document the current tables were built from never gets here, the loader recognizes
+            // it by its validators from the response headers and the table is reused instead
+            // (see revalidate below). A changed one is only fingerprinted once it is parsed.
+            state->loader->addStream(
+                Dataset::table_names[src.table],
+                src.url,
+                [state, src, dep](ChunkStream& in) {
+                    uint64_t dephash = (dep != table_max ? state->hashes[dep] : 0);
+
+                    state->data->build(src.table, in.stream());
+                    in.drain();
+
+                    uint64_t hash = Dataset::fingerprint(src.table, in.hash(), dephash);
+
+                    state->contents[src.table] = in.hash();
+                    state->hashes[src.table]   = hash;
+
+                    bool current = state->unchanged(src.table, hash);
+
+                    if (current)
+                    {
+                        // Same document under new validators, keep the current table and drop the copy
+                        state->data->share(src.table, *state->base);
+                    }
+
+                    if (current || (state->hasSnapshot && state->snapshot.hash(src.table) == hash))
+                    {
+                        state->reused[src.table] = true;
+                        state->restored++;
+                    }
+                },
+                deps);
         }
-        else if (modtype == "suffix")
+        else
         {
-            type = mod_generation_type::mod_suffix;
-        }
+            state->loader->add(
+                Dataset::table_names[src.table],
+                src.file,
+                src.url,
+                [state, src, dep](const QByteArray& raw) {
+                    // A table has to be rebuilt if its own source or a table it depends on changed
+                    uint64_t dephash = (dep != table_max ? state->hashes[dep] : 0);
+                    uint64_t content = ptadb::hash(raw.constData(), raw.size());
+                    uint64_t hash    = Dataset::fingerprint(src.table, content, dephash);
 
-        if (type == mod_generation_type::mod_unknown)
-        {
-            // We only care about magic mods for now here so
-            // skip all other mod types like corrupted/unique mods
-            // qDebug() << "Skipped mod type" << QString::fromStdString(modtype) << "in mod" << QString::fromStdString(modname);
-            continue;
+                    state->contents[src.table] = content;
+                    state->hashes[src.table]   = hash;
+
+                    if (state->reuse(src.table, hash))
+                    {
+                        return;
+                    }
+
+                    state->data->build(src.table, json::parse(raw.begin(), raw.end()));
+                },
+                deps);
         }
 
-        c_mods.insert({{modname, type}});
-    }
+        // Ask the server whether the document the current tables (or the snapshot) were built from is still
+        // current. The stored content hash stands in for the body, so an unchanged table costs a single round trip.
+        auto it = state->validators.find(src.url.toString().toStdString());
 
-    qInfo() << "Mod types loaded";
+        if (it != state->validators.end() && state->reusable(src.table))
+        {
+            const manifest_entry entry = it->second;
 
-    ///////////////////////////////////////////// Load pseudo rules
+            state->loader->revalidate(
+                Dataset::table_names[src.table],
+                QByteArray::fromStdString(entry.etag),
+                QByteArray::fromStdString(entry.lastModified),
+                [state, src, dep, entry]() -> bool {
+                    uint64_t dephash = (dep != table_max ? state->hashes[dep] : 0);
 
-    QFile pr("data/pseudo_rules.json");
+                    // A table it depends on may have changed, in which case the body is needed after all
+                    if (!state->reuse(src.table, Dataset::fingerprint(src.table, entry.content, dephash)))
+                    {
+                        return false;
+                    }
 
-    if (pr.open(QIODevice::ReadOnly))
-    {
-        QByteArray pdat = pr.readAll();
+                    state->contents[src.table] = entry.content;
 
-        c_pseudoRules = json::parse(pdat.toStdString());
-    }
-    else if (synchronizedGetJSON(QNetworkRequest(u_pta_pseudorules), data))
-    {
-        c_pseudoRules = data;
+                    return true;
+                });
+        }
     }
-    else
+
+    if (state->initial)
     {
-        throw std::runtime_error("Cannot open pseudo_rules.json");
+        connect(state->loader, &DataLoader::datasetLoaded, this, &ItemAPI::handleDatasetLoaded);
     }
 
-    qInfo() << "Pseudo rules loaded";
-
-    ///////////////////////////////////////////// Load enchant rules
-
-    QFile er("data/enchant_rules.json");
+    connect(state->loader, &DataLoader::finished, this, &ItemAPI::handleLoadFinished);
 
-    if (er.open(QIODevice::ReadOnly))
-    {
-        QByteArray edat = er.readAll();
+    state->loader->start();
+}
 
-        c_enchantRules = json::parse(edat.toStdString());
-    }
-    else if (synchronizedGetJSON(QNetworkRequest(u_pta_enchantrules), data))
-    {
-        c_enchantRules = data;
-    }
-    else
+void ItemAPI::refreshData()
+{
+    if (m_load || m_snapshotWrite.isRunning())
     {
-        throw std::runtime_error("Cannot open enchant_rules.json");
+        // Still busy with the previous load or its snapshot
+        return;
     }
 
-    qInfo() << "Enchant rules loaded";
+    qDebug() << "Checking datasets for updates";
 
-    ///////////////////////////////////////////// Load local rules
+    startLoad();
+}
 
-    QFile wl("data/weapon_locals.json");
+ItemAPI::~ItemAPI()
+{
+    QSettings settings;
 
-    if (wl.open(QIODevice::ReadOnly))
+    if (settings.value(PTA_CONFIG_PERSIST_PARSE_CACHE, false).toBool())
     {
-        QByteArray wdat = wl.readAll();
-
-        json wlr = json::parse(wdat.toStdString());
+        ParseContext ctx = parseContext();
 
-        for (const auto& e : wlr["data"])
+        if (!m_parseCache.save(parseCachePath(), ctx.dataKey, ctx.gen))
         {
-            c_weaponLocals.insert(e.get<std::string>());
+            qWarning() << "Failed to write parse cache to" << parseCachePath();
         }
     }
-    else if (synchronizedGetJSON(QNetworkRequest(u_pta_weaponlocals), data))
+
+    // Let the snapshot write finish so the next start can pick it up
+    m_snapshotWrite.waitForFinished();
+
+    // The ingest workers write straight into the tables of the load
+    if (m_load)
     {
-        for (const auto& e : data["data"])
+        m_load->warm.waitForFinished();
+
+        if (m_load->loader)
         {
-            c_weaponLocals.insert(e.get<std::string>());
+            m_load->loader->disconnect(this);
+            m_load->loader->abort();
+            delete m_load->loader;
         }
     }
-    else
+}
+
+bool ItemAPI::isReady(data_tier tier) const
+{
+    return tierLoaded(dataset()->loaded(), tier);
+}
+
+bool ItemAPI::waitForTier(data_tier tier)
+{
+    if (!isReady(tier) && m_loadError.isEmpty())
     {
-        throw std::runtime_error("Cannot open weapon_locals.json");
+        QEventLoop loop;
+        connect(this, &ItemAPI::tierReady, &loop, [&]() {
+            if (isReady(tier))
+            {
+                loop.quit();
+            }
+        });
+        connect(this, &ItemAPI::loadFailed, &loop, &QEventLoop::quit);
+
+        loop.exec();
     }
 
-    qInfo() << "Weapon Local rules loaded";
+    return isReady(tier);
+}
+
+data_tier ItemAPI::requiredTier(const QString& itemText) const
+{
+    // Newer clients lead with the item class
+    int first = (itemText.startsWith("Item Class:") ? 1 : 0);
 
-    /////////////////////////////////////////////  Armour locals
-    QFile al("data/armour_locals.json");
+    item_rarity_e rarity = readRarity(itemText.section('\n', first, first).section(": ", 1, 1).trimmed().toStdString());
 
-    if (al.open(QIODevice::ReadOnly))
+    // Bulk exchange currency only needs the currency table
+    if (rarity == rarity_currency)
     {
-        QByteArray adat = al.readAll();
-
-        json alr = json::parse(adat.toStdString());
+        QString type = itemText.section('\n', first + 1, first + 1).trimmed();
 
-        for (const auto& e : alr["data"])
+        if (dataset()->currencies().find(type.toStdString()) != CurrencyTable::npos)
         {
-            c_armourLocals.insert(e.get<std::string>());
+            return tier_core;
         }
     }
-    else if (synchronizedGetJSON(QNetworkRequest(u_pta_armourlocals), data))
+
+    // Gems and cards get their category from the rarity line and never touch the base tables
+    if (rarity == rarity_gem || rarity == rarity_card)
     {
-        for (const auto& e : data["data"])
-        {
-            c_armourLocals.insert(e.get<std::string>());
-        }
+        return tier_stats;
     }
-    else
+
+    // Only magic names carry affixes around their base type
+    if (rarity == rarity_magic)
+    {
+        return tier_full;
+    }
+
+    return tier_bases;
+}
+
+void ItemAPI::handleDatasetLoaded(const QString& name)
+{
+    qInfo() << "Loaded" << name;
+
+    auto it = std::find(Dataset::table_names.begin(), Dataset::table_names.end(), name);
+
+    if (it == Dataset::table_names.end() || !m_load)
     {
-        throw std::runtime_error("Cannot open armour_locals.json");
+        return;
     }
 
-    qInfo() << "Armour Local rules loaded";
+    publishTables(1u << std::distance(Dataset::table_names.begin(), it));
+}
 
-    ///////////////////////////////////////////// Mod Discriminators
+void ItemAPI::publishTables(uint32_t tables)
+{
+    LoadState* state = m_load.get();
 
-    QFile disc("data/discriminators.json");
+    std::array<bool, tier_max> before;
 
-    if (disc.open(QIODevice::ReadOnly))
+    for (uint8_t t = 0; t < tier_max; t++)
     {
-        QByteArray ddat = disc.readAll();
+        before[t] = isReady(static_cast<data_tier>(t));
+    }
+
+    // Tables are only shared once they are sealed, a parse never sees one being built
+    auto next = std::make_shared<Dataset>(*m_data.load());
 
-        json dcr = json::parse(ddat.toStdString());
+    next->generation = 1;
 
-        for (const auto [entry, list] : dcr.items())
+    for (uint32_t t = 0; t < table_max; t++)
+    {
+        if (tables & (1u << t))
         {
-            for (const auto value : list["unused"])
-            {
-                c_discriminators[entry].insert(value.get<std::string>());
-            }
+            state->data->fingerprints[t] = state->hashes[t];
+            next->share(static_cast<dataset_table>(t), *state->data);
         }
     }
-    else if (synchronizedGetJSON(QNetworkRequest(u_pta_disc), data))
+
+    m_data.store(next);
+
+    for (uint8_t t = 0; t < tier_max; t++)
     {
-        for (const auto [entry, list] : data.items())
+        if (!before[t] && isReady(static_cast<data_tier>(t)))
         {
-            for (const auto value : list["unused"])
+            state->tierMs[t] = state->timer.nsecsElapsed() / 1e6;
+
+            qInfo() << "Data tier" << c_tierNames[t] << "ready";
+
+            if (t == tier_core)
             {
-                c_discriminators[entry].insert(value.get<std::string>());
+                qInfo() << "League data loaded. Setting league to" << getLeague();
             }
+
+            emit tierReady(static_cast<data_tier>(t));
         }
     }
-    else
+}
+
+void ItemAPI::handleLoadFinished()
+{
+    std::unique_ptr<LoadState> state = std::move(m_load);
 
+    state->loader->deleteLater();
+
+    if (state->loader->failed())
     {
-        throw std::runtime_error("Cannot open discriminators.json");
+        if (!state->initial)
+        {
+            // Keep serving the current generation
+            qWarning() << "Dataset refresh failed:" << state->loader->errorString();
+            return;
+        }
+
+        m_loadError = state->loader->errorString();
+        emit loadFailed(m_loadError);
+        return;
     }
 
-    qInfo() << "Discriminator rules loaded";
+    manifest current;
 
-    ///////////////////////////////////////////// Currency
+    for (const auto& src : c_sources)
+    {
+        QString    name         = Dataset::table_names[src.table];
+        QByteArray etag         = state->loader->etag(name);
+        QByteArray lastModified = state->loader->lastModified(name);
 
-    QFile curr("data/currency.json");
+        if (!etag.isEmpty() || !lastModified.isEmpty())
+        {
+            current[src.url.toString().toStdString()] = {etag.toStdString(), lastModified.toStdString(), state->contents[src.table]};
+        }
+    }
+
+    m_validators->entries = current;
 
-    if (curr.open(QIODevice::ReadOnly))
+    if (!state->initial && state->changed())
     {
-        QByteArray cdat = curr.readAll();
+        // Requests already holding the old generation keep it alive until they are done with it.
+        // Tables of unchanged sources are the very same ones, shared by both generations
+        state->data->generation   = m_data.load()->generation + 1;
+        state->data->fingerprints = state->hashes;
+        m_data.store(state->data);
 
-        c_currencyMap = json::parse(cdat.toStdString());
+        qInfo() << "Published dataset generation" << state->data->generation;
     }
-    else if (synchronizedGetJSON(QNetworkRequest(u_pta_currency), data))
+
+    if (state->restored < table_max || current != state->validators)
     {
-        c_currencyMap = data;
+        // Something changed upstream, write a fresh snapshot for the next run. The tables are
+        // sealed and already served, so nothing waits for the file
+        std::shared_ptr<const Dataset> data = state->data;
+
+        m_snapshotWrite = QtConcurrent::run([data, hashes = state->hashes, current, rebuilt = table_max - state->restored]() {
+            writeSnapshot(*data, hashes, current, rebuilt);
+        });
     }
     else
     {
-        throw std::runtime_error("Cannot open currency.json");
+        qInfo() << (state->initial ? "All datasets restored from snapshot" : "Datasets are up to date");
     }
 
-    for (const auto& [k, v] : c_currencyMap.items())
+    if (state->initial)
     {
-        c_currencyCodes.insert(v.get<std::string>());
+        reportStartup(*state);
     }
-
-    qInfo() << "Currency rules loaded";
 }
 
-int ItemAPI::readPropInt(QString prop)
+void ItemAPI::reportStartup(const LoadState& state) const
 {
-    // Remove augmented tag
-    prop.replace(" (augmented)", "");
-
-    QRegularExpression      re("^([\\+\\-]?[\\d\\.]+)%?");
-    QRegularExpressionMatch match = re.match(prop);
-
-    if (match.hasMatch())
-    {
-        QString val = match.captured(1);
-        return val.toInt();
-    }
+    double elapsed = state.timer.nsecsElapsed() / 1e6;
 
-    return 0;
-}
+    json report = {{"total_ms", elapsed}, {"snapshot", state.hasSnapshot}};
 
-json ItemAPI::readPropIntRange(QString prop)
-{
-    json val = {{"min", 0}, {"max", 0}};
+    qInfo().noquote() << QString("%1 %2 %3 %4 %5 %6 %7 %8")
+                             .arg("dataset", -22)
+                             .arg("origin", -13)
+                             .arg("KiB", 9)
+                             .arg("fetch ms", 9)
+                             .arg("ingest ms", 10)
+                             .arg("total ms", 9)
+                             .arg("table", -8)
+                             .arg("entries", 8);
 
-    // If it is a list, process list
-    if (prop.contains(", "))
+    for (const auto& src : c_sources)
     {
-        // Split and recursively read
-        auto list = prop.split(", ", QString::SkipEmptyParts);
+        QString             name    = Dataset::table_names[src.table];
+        DataLoader::Profile prof    = (state.loader ? state.loader->profile(name) : DataLoader::Profile());
+        const char*         origin  = (state.loader ? c_originNames[static_cast<size_t>(prof.source)] : "snapshot");
+        const char*         table   = (state.reused[src.table] ? "snapshot" : "built");
+        size_t              entries = state.data->size(src.table);
 
-        for (auto& item : list)
+        if (!state.loader)
         {
-            json nxt   = readPropIntRange(item);
-            val[p_min] = val[p_min].get<int>() + nxt[p_min].get<int>();
-            val[p_max] = val[p_max].get<int>() + nxt[p_max].get<int>();
+            // Warm start, nothing was fetched
+            prof.ingestMs = state.restoreMs[src.table];
+            prof.totalMs  = state.restoreMs[src.table];
         }
 
-        return val;
+        qInfo().noquote() << QString("%1 %2 %3 %4 %5 %6 %7 %8")
+                                 .arg(name, -22)
+                                 .arg(origin, -13)
+                                 .arg(prof.bytes / 1024.0, 9, 'f', 1)
+                                 .arg(prof.fetchMs, 9, 'f', 1)
+                                 .arg(prof.ingestMs, 10, 'f', 1)
+                                 .arg(prof.totalMs, 9, 'f', 1)
+                                 .arg(table, -8)
+                                 .arg(entries, 8);
+
+        report["datasets"].push_back({{"name", name.toStdString()},
+                                      {"tier", c_tierNames[src.tier]},
+                                      {"origin", origin},
+                                      {"bytes", prof.bytes},
+                                      {"fetch_ms", prof.fetchMs},
+                                      {"ingest_ms", prof.ingestMs},
+                                      {"total_ms", prof.totalMs},
+                                      {"from_snapshot", state.reused[src.table]},
+                                      {"entries", entries}});
     }
 
-    // Otherwise process single entry
+    for (uint8_t t = 0; t < tier_max; t++)
+    {
+        report["tiers"][c_tierNames[t]] = state.tierMs[t];
+    }
 
-    // Remove augmented tag
-    prop.replace(" (augmented)", "");
+    qInfo().noquote() << QString("Datasets loaded in %1 ms (core %2 ms, stats %3 ms, bases %4 ms, full %5 ms)")
+                             .arg(elapsed, 0, 'f', 1)
+                             .arg(state.tierMs[tier_core], 0, 'f', 1)
+                             .arg(state.tierMs[tier_stats], 0, 'f', 1)
+                             .arg(state.tierMs[tier_bases], 0, 'f', 1)
+                             .arg(state.tierMs[tier_full], 0, 'f', 1);
 
-    QRegularExpression      re("^(\\d+)-(\\d+)");
-    QRegularExpressionMatch match = re.match(prop);
+    QSettings settings;
 
-    if (match.hasMatch())
+    if (!settings.value(PTA_CONFIG_STARTUP_REPORT, false).toBool())
     {
-        QString v1 = match.captured(1);
-        QString v2 = match.captured(2);
-
-        val[p_min] = v1.toInt();
-        val[p_max] = v2.toInt();
+        return;
     }
 
-    return val;
-}
-
-double ItemAPI::readPropFloat(QString prop)
-{
-    // Remove augmented tag
-    prop.replace(" (augmented)", "");
+    QDir().mkpath(QFileInfo(startupReportPath()).absolutePath());
 
-    QRegularExpression      re("^([\\+\\-]?[\\d\\.]+)%?");
-    QRegularExpressionMatch match = re.match(prop);
+    QSaveFile   sf(startupReportPath());
+    std::string out = report.dump(4);
 
-    if (match.hasMatch())
+    if (sf.open(QIODevice::WriteOnly) && sf.write(out.data(), out.size()) == qint64(out.size()) && sf.commit())
+    {
+        qInfo() << "Startup profile written to" << startupReportPath();
+    }
+    else
     {
-        QString val = match.captured(1);
-        return val.toDouble();
+        qWarning() << "Failed to write startup profile to" << startupReportPath();
     }
+}
 
-    return 0.0;
+std::string ItemAPI::readName(std::string_view name) const
+{
+    return stripTags(name);
 }
 
-json ItemAPI::readSockets(QString prop)
+std::string ItemAPI::readType(const ParseContext& ctx, Item& item, std::string_view line) const
 {
-    json sockets;
+    const Dataset& gen = *ctx.gen;
 
-    sockets["links"] = 0;
-    sockets["total"] = 0;
-    sockets["R"]     = 0;
-    sockets["G"]     = 0;
-    sockets["B"]     = 0;
-    sockets["W"]     = 0;
-    sockets["A"]     = 0;
+    std::string type = stripTags(line);
 
-    auto llist = prop.split(" ", QString::SkipEmptyParts);
+    eraseAll(type, "Superior ");
 
-    for (auto& lpart : llist)
+    if (type.starts_with("Synthesised "))
     {
-        auto socks = lpart.split("-", QString::SkipEmptyParts);
+        eraseAll(type, "Synthesised ");
+        item.set(field_misc_synthesis);
+    }
 
-        if (socks.length() > 1 && socks.length() > sockets["links"].get<int>())
+    if (item.rarity == rarity_magic)
+    {
+        if (!ctx.affixes.empty())
         {
-            // New max links
-            sockets["links"] = socks.length();
+            // Advanced copies name the affixes, so cut exactly those
+            for (const auto& a : ctx.affixes)
+            {
+                size_t len = a.affix.size();
+
+                if (a.generation == mod_generation_type::mod_prefix && type.size() > len && type.starts_with(a.affix) && type[len] == ' ')
+                {
+                    type.erase(0, len + 1);
+                }
+                else if (a.generation == mod_generation_type::mod_suffix && type.size() > len && type.ends_with(a.affix) && type[type.size() - len - 1] == ' ')
+                {
+                    type.resize(type.size() - len - 1);
+                }
+            }
+
+            return type;
         }
 
-        for (const auto& s : socks)
+        if (ctx.has(table_mods))
         {
-            auto clr         = s.toStdString();
-            sockets[clr]     = sockets[clr].get<int>() + 1;
-            sockets["total"] = sockets["total"].get<int>() + 1;
+            // Cut the affixes off at both ends, preferring a split that leaves a known base
+            AffixTable::Split parts = gen.mods().split(type, (ctx.has(table_bases) ? &gen.bases() : nullptr));
+
+            return std::string(parts.base);
         }
-    }
 
-    return sockets;
-}
+        // Without the affix names, at least drop the suffix
+        size_t suffix = type.find(" of ");
 
-std::string ItemAPI::readName(QString name)
-{
-    name.remove(QRegularExpression("<<.*?>>|<.*?>"));
+        if (suffix != std::string::npos && suffix > 0)
+        {
+            type.resize(suffix);
+        }
+    }
 
-    return name.toStdString();
+    return type;
 }
 
-std::string ItemAPI::readType(Item& item, QString type)
+ItemAPI::ParseContext::ModHeader ItemAPI::readModHeader(const ParseContext& ctx, std::string_view line) const
 {
-    type.remove(QRegularExpression("<<.*?>>|<.*?>"));
-    type.remove("Superior ");
+    ParseContext::ModHeader mod;
+
+    size_t open  = line.find('"');
+    size_t close = (open != std::string_view::npos ? line.find('"', open + 1) : std::string_view::npos);
 
-    if (type.startsWith("Synthesised "))
+    if (close != std::string_view::npos)
     {
-        type.remove("Synthesised ");
-        item[p_msynth] = true;
+        mod.affix = line.substr(open + 1, close - open - 1);
     }
 
-    if (item[p_rarity].get<std::string>() == "Magic")
+    // What kind of mod it is comes before the affix name and the tags
+    std::string_view kind = line.substr(0, (open != std::string_view::npos ? open : line.find(em_dash)));
+
+    auto has = [&](std::string_view word) { return (kind.find(word) != std::string_view::npos); };
+
+    if (has("Crafted"))
+    {
+        mod.type = stat_crafted;
+    }
+    else if (has("Implicit"))
+    {
+        mod.type = stat_implicit;
+    }
+    else if (has("Fractured"))
+    {
+        mod.type = stat_fractured;
+    }
+    else if (has("Enchant"))
     {
-        // Parse out magic affixes
-        // Try to get rid of all suffixes by forward catching " of"
-        QRegularExpression              re("([\\w'-]+)(?(?= of)( of [\\w\\s]+))");
-        QRegularExpressionMatchIterator i = re.globalMatch(type);
+        mod.type = stat_enchant;
+    }
+    else
+    {
+        mod.type = stat_explicit;
+    }
 
-        QStringList words;
-        while (i.hasNext())
-        {
-            QRegularExpressionMatch match = i.next();
-            QString                 word  = match.captured(1);
-            words << word;
-        }
+    if (has("Prefix"))
+    {
+        mod.generation = mod_generation_type::mod_prefix;
+    }
+    else if (has("Suffix"))
+    {
+        mod.generation = mod_generation_type::mod_suffix;
+    }
 
-        std::string prefix = words.at(0).toStdString();
+    // Trust the RePoE record of a named affix over the header
+    if (!mod.affix.empty() && ctx.has(table_mods))
+    {
+        AffixTable::index_t idx = ctx.gen->mods().find(mod.affix);
 
-        // Remove prefixes
-        if (c_mods.contains(prefix) && c_mods[prefix] == mod_generation_type::mod_prefix)
+        if (idx != AffixTable::npos)
         {
-            words.removeAt(0);
+            mod.generation = ctx.gen->mods().type(idx);
         }
-
-        type = words.join(' ');
     }
 
-    return type.toStdString();
+    return mod;
 }
 
-void ItemAPI::captureNumerics(QString line, QRegularExpression& re, json& val, std::vector<QString>& captured)
+std::string ItemAPI::maskNumerics(std::string_view line, std::string_view mask) const
 {
-    QRegularExpressionMatchIterator it = re.globalMatch(line);
+    std::string_view token;
+    std::string      out;
+    size_t           pos  = 0;
+    size_t           last = 0;
 
-    while (it.hasNext())
+    out.reserve(line.size());
+
+    while (propscan::nextNumber(line, pos, token))
     {
-        QRegularExpressionMatch match = it.next();
-        QString                 word  = match.captured(1);
+        size_t start = static_cast<size_t>(token.data() - line.data());
 
-        captured.push_back(word);
+        out.append(line.substr(last, start - last));
+        out.append(mask);
 
-        // Process floats
-        if (word.contains('.'))
-        {
-            double numval = word.toDouble();
-            val.push_back(numval);
-        }
-        else
-        {
-            int numval = word.toInt();
-            val.push_back(numval);
-        }
+        last = pos;
     }
+
+    out.append(line.substr(last));
+
+    return out;
 }
 
-void ItemAPI::parseProp(Item& item, QString prop)
+void ItemAPI::parseProp(ParseContext& ctx, Item& item, std::string_view p, std::string_view v) const
 {
-    QString p = prop.section(":", 0, 0);
-    QString v = prop.section(": ", 1, 1);
+    auto pev = c_propMap.find(p);
 
-    if (!c_propMap.contains(p))
+    if (!pev)
     {
-        qDebug() << "Unknown/unimplemented prop:" << p;
+        qDebug() << "Unknown/unimplemented prop:" << qstr(p);
         return;
     }
 
-    auto& pev = c_propMap[p];
-
-    switch (pev[0])
+    switch (pev->type)
     {
         case weapon_filter:
         {
-            switch (pev[1])
+            switch (pev->filter)
             {
                 case weapon_filter_pdps:
                 {
-                    item[p_wpdps] = readPropIntRange(v);
+                    item.weapon.pdps = propscan::readIntRange(v);
+                    item.set(field_weapon_pdps);
                     break;
                 }
 
                 case weapon_filter_crit:
                 {
-                    item[p_wcrit] = readPropFloat(v);
+                    item.weapon.crit = propscan::readFloat(v);
+                    item.set(field_weapon_crit);
                     break;
                 }
 
                 case weapon_filter_aps:
                 {
-                    item[p_waps] = readPropFloat(v);
+                    item.weapon.aps = propscan::readFloat(v);
+                    item.set(field_weapon_aps);
                     break;
                 }
 
                 case weapon_filter_edps:
                 {
-                    item[p_wedps] = readPropIntRange(v);
+                    item.weapon.edps = propscan::readIntRange(v);
+                    item.set(field_weapon_edps);
                     break;
                 }
             }
 
-            item[p_weapon][p_enabled] = false;
-
             break;
         }
 
         case armour_filter:
         {
-            switch (pev[1])
+            switch (pev->filter)
             {
                 case armour_filter_ar:
                 {
-                    item[p_aar] = readPropInt(v);
+                    item.armour.ar = propscan::readInt(v);
+                    item.set(field_armour_ar);
                     break;
                 }
 
                 case armour_filter_ev:
                 {
-                    item[p_aev] = readPropInt(v);
+                    item.armour.ev = propscan::readInt(v);
+                    item.set(field_armour_ev);
                     break;
                 }
 
                 case armour_filter_es:
                 {
-                    item[p_aes] = readPropInt(v);
+                    item.armour.es = propscan::readInt(v);
+                    item.set(field_armour_es);
                     break;
                 }
 
                 case armour_filter_block:
                 {
-                    item[p_ablock] = readPropInt(v);
+                    item.armour.block = propscan::readInt(v);
+                    item.set(field_armour_block);
                     break;
                 }
             }
 
-            item[p_armour][p_enabled] = false;
-
             break;
         }
 
         case socket_filter:
         {
-            item[p_sockets] = readSockets(v);
+            item.sockets = propscan::readSockets(v);
+            item.set(field_sockets);
             break;
         }
 
         case req_filter:
         {
-            switch (pev[1])
+            switch (pev->filter)
             {
                 case req_filter_lvl:
                 {
-                    item[p_reqlvl] = readPropInt(v);
+                    item.requirements.lvl = propscan::readInt(v);
+                    item.set(field_req_lvl);
                     break;
                 }
 
                 case req_filter_str:
                 {
-                    item[p_reqstr] = readPropInt(v);
+                    item.requirements.str = propscan::readInt(v);
+                    item.set(field_req_str);
                     break;
                 }
 
                 case req_filter_dex:
                 {
-                    item[p_reqdex] = readPropInt(v);
+                    item.requirements.dex = propscan::readInt(v);
+                    item.set(field_req_dex);
                     break;
                 }
 
                 case req_filter_int:
                 {
-                    item[p_reqint] = readPropInt(v);
+                    item.requirements.intell = propscan::readInt(v);
+                    item.set(field_req_int);
                     break;
                 }
             }
@@ -726,35 +1309,40 @@ void ItemAPI::parseProp(Item& item, QString prop)
 
         case misc_filter:
         {
-            switch (pev[1])
+            switch (pev->filter)
             {
                 case misc_filter_quality:
                 {
-                    item[p_quality] = readPropInt(v);
+                    item.quality = propscan::readInt(v);
+                    item.set(field_quality);
                     break;
                 }
 
                 case misc_filter_gem_level:
                 {
-                    item[p_mglvl] = readPropInt(v);
+                    item.misc.gemLevel = propscan::readInt(v);
+                    item.set(field_misc_gem_level);
                     break;
                 }
 
                 case misc_filter_ilvl:
                 {
-                    item[p_ilvl] = readPropInt(v);
+                    item.ilvl = propscan::readInt(v);
+                    item.set(field_ilvl);
                     break;
                 }
 
                 case misc_filter_gem_level_progress:
                 {
-                    item[p_mgexp] = v.toStdString();
+                    item.misc.gemProgress = std::string(v);
+                    item.set(field_misc_gem_progress);
                     break;
                 }
 
                 case misc_filter_map_tier:
                 {
-                    item[p_mmtier] = readPropInt(v);
+                    item.misc.mapTier = propscan::readInt(v);
+                    item.set(field_misc_map_tier);
                     break;
                 }
             }
@@ -764,348 +1352,221 @@ void ItemAPI::parseProp(Item& item, QString prop)
 
         case special_filter:
         {
-            if (p == "Requirements")
+            switch (pev->filter)
             {
-                m_section = "Requirements";
-                break;
-            }
-
-            if (p == "Level")
-            {
-                QString fprop = "gem_level: ";
-
-                if (m_section == "Requirements")
+                case special_filter_requirements:
                 {
-                    fprop = "req_level: ";
-                }
-
-                QString cprop = fprop + v;
-                parseProp(item, cprop);
-                break;
-            }
-
-            qDebug() << "Unknown/unimplemented special prop:" << p;
-
-            break;
-        }
-    }
-}
-
-bool ItemAPI::parseStat(Item& item, QString stat, QTextStream& stream)
-{
-    QString orig_stat = stat;
-
-    // Special rule for A Master Seeks Help
-    if (item.contains(p_category) && item[p_category].get<std::string>() == "prophecy" && item[p_name].get<std::string>() == "A Master Seeks Help")
-    {
-        QRegularExpression      re("^You will find (\\w+) and complete her mission.$");
-        QRegularExpressionMatch match = re.match(stat);
-        if (match.hasMatch())
-        {
-            QString master = match.captured(1);
-
-            item[p_mdisc] = master.toLower().toStdString();
-        }
-
-        return true;
-    }
+                    ctx.requirements = true;
+                    break;
+                }
 
-    if (stat == "Unidentified")
-    {
-        item[p_unidentified] = true;
-        return true;
-    }
+                case special_filter_level:
+                {
+                    parseProp(ctx, item, (ctx.requirements ? "req_level" : "gem_level"), v);
+                    break;
+                }
+            }
 
-    if (stat == "Shaper Item")
-    {
-        item[p_influences].push_back(c_influenceMap[shaper]);
-        return true;
+            break;
+        }
     }
+}
 
-    if (stat == "Elder Item")
-    {
-        item[p_influences].push_back(c_influenceMap[elder]);
-        return true;
-    }
+bool ItemAPI::parseStat(const ParseContext& ctx, Item& item, std::string_view stat, propscan::LineReader& lines) const
+{
+    const Dataset& gen = *ctx.gen;
 
-    if (stat == "Crusader Item")
-    {
-        item[p_influences].push_back(c_influenceMap[crusader]);
-        return true;
-    }
+    std::string_view orig_stat = stat;
 
-    if (stat == "Redeemer Item")
+    // Special rule for A Master Seeks Help
+    if (item.category == cat_prophecy && item.name == "A Master Seeks Help")
     {
-        item[p_influences].push_back(c_influenceMap[redeemer]);
+        constexpr std::string_view prefix = "You will find ";
+        constexpr std::string_view suffix = " and complete her mission.";
 
-        return true;
-    }
+        if (stat.size() > prefix.size() + suffix.size() && stat.starts_with(prefix) && stat.ends_with(suffix))
+        {
+            std::string master(stat.substr(prefix.size(), stat.size() - prefix.size() - suffix.size()));
 
-    if (stat == "Hunter Item")
-    {
-        item[p_influences].push_back(c_influenceMap[hunter]);
+            bool word = std::all_of(master.begin(), master.end(), [](unsigned char c) { return (std::isalnum(c) || c == '_'); });
 
-        return true;
-    }
+            if (word)
+            {
+                std::transform(master.begin(), master.end(), master.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
 
-    if (stat == "Warlord Item")
-    {
-        item[p_influences].push_back(c_influenceMap[warlord]);
+                item.misc.disc = master;
+                item.set(field_misc_disc);
+            }
+        }
 
         return true;
     }
 
-    if (stat == "Corrupted")
+    // Unidentified, influenced and the like
+    if (auto flag = c_flagLines.find(stat))
     {
-        item[p_corrupted] = true;
-        return true;
-    }
+        if (flag->influence < influences_max)
+        {
+            item.influences.set(flag->influence);
+        }
 
-    if (stat == "Synthesised Item")
-    {
-        // Should already have been processed
-        item[p_msynth] = true;
+        item.set(flag->fields);
         return true;
     }
 
     // Vaal gems
-    if (item.contains(p_category) && item[p_category].get<std::string>() == "gem" && stat.startsWith("Vaal "))
+    if (item.category == cat_gem && stat.starts_with("Vaal "))
     {
-        item[p_type] = stat.toStdString();
+        item.type = std::string(stat);
         return true;
     }
 
-    // PoE 3.9 adds the "(implicit)" description so we no longer have to guess
-    std::string stat_type;
+    // PoE 3.9 adds the "(implicit)" description so we no longer have to guess.
+    // Advanced copies say what every mod is in its header
+    stat_type_e stat_type = ctx.mod.type;
 
-    if (stat.endsWith("(crafted)"))
+    if (stat.ends_with(" (crafted)"))
     {
-        stat_type = "crafted";
+        stat_type = stat_crafted;
+        stat.remove_suffix(std::string_view(" (crafted)").size());
     }
-
-    if (stat.endsWith("(implicit)"))
+    else if (stat.ends_with(" (implicit)"))
     {
-        stat_type = "implicit";
+        stat_type = stat_implicit;
+        stat.remove_suffix(std::string_view(" (implicit)").size());
     }
 
-    stat.replace(" (crafted)", "");
-    stat.replace(" (implicit)", "");
-
-    // Match numerics
-    QRegularExpression   re("([\\+\\-]?[\\d\\.]+)");
-    std::vector<QString> captured;
-
-    json val    = json::array();
-    auto stoken = stat.toStdString();
+    // Only the local rules below make a line resolve differently from item to item
+    uint32_t variant = (item.has(field_weapon) ? 1 : 0) | (item.has(field_armour) ? 2 : 0);
+    uint64_t lineKey = StatMissCache::lineKey(stat, variant);
 
-    // First try original line
-    bool found = m_stats_by_text.contains(stoken);
-
-    if (!found)
+    if (m_statMisses.contains(ctx.dataKey, lineKey))
     {
-        // Then, try replacing the num stats
-        captureNumerics(stat, re, val, captured);
-
-        // Craft search token
-        stat.replace(re, "#");
-
-        stoken = stat.toStdString();
-        found  = m_stats_by_text.contains(stoken);
+        return false;
     }
 
-    // Process local rules
-    if (item.contains(p_weapon) || item.contains(p_armour))
-    {
-        bool is_local_stat = ((item.contains(p_weapon) && c_weaponLocals.contains(stoken)) || (item.contains(p_armour) && c_armourLocals.contains(stoken)));
+    // A line the table matched is followed by the stat it matched. Only the
+    // rest need their text, with every number replaced, for the rules below
+    ItemFilter         val;
+    std::string        stoken;
+    StatTable::index_t textStat = StatTable::npos; // a stat whose first line the line reads as
 
-        if (is_local_stat)
-        {
-            stat += " (Local)";
+    // Resolve the line against every stat text at once
+    StatTable::Match match;
 
-            stoken = stat.toStdString();
-            found  = m_stats_by_text.contains(stoken);
-        }
-    }
+    bool found = gen.stats().match(stat, match);
 
-    if (!found && val.size() && (stat.contains("reduced") || stat.contains("less")))
+    if (found)
     {
-        // If the stat line has a "reduced" value, try to
-        // flip it and try again
+        textStat = match.stat;
 
-        if (stat.contains("reduced"))
-        {
-            stat.replace("reduced", "increased");
-            // orig_stat.replace("reduced", "increased");
-        }
-        else
+        for (size_t i = 0; i < match.count; i++)
         {
-            stat.replace("less", "more");
-            // orig_stat.replace("less", "more");
+            readNumeric(match.values[i], val);
         }
 
-        // replace last
-        auto& v = val[val.size() - 1];
-
-        if (v.is_number_float())
-        {
-            v = v.get<double>() * -1.0;
-        }
-        else
+        if (match.flipped && val.count)
         {
-            v = v.get<int>() * -1;
+            // Matched a "reduced" line as its "increased" stat, so negate the last value
+            val.values[val.count - 1] *= -1.0;
         }
+    }
+    else
+    {
+        propscan::readNumerics(stat, val);
 
-        stoken = stat.toStdString();
-        found  = m_stats_by_text.contains(stoken);
+        stoken = maskNumerics(stat, "#");
     }
 
-    // Handle enchant rules
-    if (c_enchantRules.contains(stoken))
+    // Process local rules
+    if (item.has(field_weapon | field_armour))
     {
-        auto& rule = c_enchantRules[stoken];
+        auto localOf = [&](const LocalTable& locals) { return (textStat != StatTable::npos ? locals.alternate(textStat) : locals.alternate(stoken)); };
 
-        if (rule.contains("id"))
-        {
-            found = true;
+        StatTable::index_t local = (item.has(field_weapon) ? localOf(gen.localWeaponStats()) : StatTable::npos);
 
-            stoken = m_stats_by_id[rule["id"].get<std::string>()]["text"].get<std::string>();
-            stat   = QString::fromStdString(stoken);
+        if (local == StatTable::npos && item.has(field_armour))
+        {
+            local = localOf(gen.localArmourStats());
         }
 
-        if (rule.contains("value"))
+        if (local != StatTable::npos)
         {
-            val.push_back(rule["value"]);
+            textStat = local;
+            found    = true;
         }
     }
 
-    if (!found)
+    // Handle enchant rules
+    if (auto rule = (textStat != StatTable::npos ? gen.enchants().find(textStat) : gen.enchants().find(stoken)))
     {
-        // Try forward replace search
-        QString frep     = orig_stat;
-        QString frepplus = frep;
-
-        while (!found && frep.contains(re) && captured.size())
+        if (rule->stat != StatTable::npos)
         {
-            // Try putting back some values in case the mod itself has hardcoded values
-            frep.replace(frep.indexOf(re), captured[0].length(), "#");
-            frepplus.replace(frepplus.indexOf(re), captured[0].length(), "+#");
-
-            stoken = frep.toStdString();
-            found  = m_stats_by_text.contains(stoken);
-
-            if (!found)
-            {
-                // Try plus version
-                stoken = frepplus.toStdString();
-                found  = m_stats_by_text.contains(stoken);
-            }
-
-            if (found)
-            {
-                // Delete value used
-                captured.pop_back();
-                val.erase(val.size() - 1);
-            }
+            textStat = rule->stat;
+            found    = true;
         }
-    }
 
-    if (!found)
-    {
-        // Reverse replace search
-        QString rrep     = orig_stat;
-        QString rrepplus = rrep;
-        while (!found && rrep.contains(re) && captured.size())
+        if (rule->hasValue)
         {
-            // Try putting back some values in case the mod itself has hardcoded values
-            rrep.replace(rrep.lastIndexOf(re), captured[captured.size() - 1].length(), "#");
-            rrepplus.replace(rrepplus.lastIndexOf(re), captured[captured.size() - 1].length(), "+#");
-
-            stoken = rrep.toStdString();
-            found  = m_stats_by_text.contains(stoken);
-
-            if (!found)
-            {
-                // Try plus version
-                stoken = rrepplus.toStdString();
-                found  = m_stats_by_text.contains(stoken);
-            }
-
-            if (found)
-            {
-                // Delete value used
-                captured.erase(captured.begin());
-                val.erase(0);
-            }
+            val.push(rule->value, rule->real);
         }
     }
 
     // Give up
     if (!found)
     {
-        qDebug() << "Ignored/unprocessed line" << orig_stat;
+        qDebug() << "Ignored/unprocessed line" << qstr(orig_stat);
+        m_statMisses.insert(ctx.dataKey, lineKey);
         return false;
     }
 
-    std::vector<QString> multiline;
-    json                 filter;
-
-    auto range = m_stats_by_text.equal_range(stoken);
-    for (auto it = range.first; it != range.second; ++it)
-    {
-        auto& entry = it->second;
-
-        std::string text = entry["text"];
+    std::vector<std::string_view> multiline;
+    ItemFilter                    filter;
 
-        std::stringstream ss(text);
-        std::string       tl;
+    // Stats that share a text with others but are not searched for this category
+    std::string_view categoryName = item.categoryName();
 
-        std::vector<QString> lines;
+    auto discriminated = [&](StatTable::index_t entry) { return gen.discriminated().excludes(entry, item.category, categoryName); };
 
-        while (std::getline(ss, tl, '\n'))
-        {
-            lines.push_back(QString::fromStdString(tl));
-        }
+    auto range = (textStat != StatTable::npos ? gen.stats().sameText(textStat) : gen.stats().byText(stoken));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        StatTable::index_t entry = *it;
 
-        // Bump the first line since we know it has matched
-        lines.erase(lines.begin());
+        // The first line is known to match, the rest are read from the item
+        size_t tails = gen.stats().continuationCount(entry);
 
-        if (lines.size() > 0)
+        if (tails > 0)
         {
             // If this is a multiline mod
             // Match the other lines as well
             bool matches = true;
 
             // Read in the other lines if we haven't yet
-            while (multiline.size() < lines.size())
+            while (multiline.size() < tails)
             {
-                QString nextline;
+                std::string_view nextline;
 
-                stream.readLineInto(&nextline);
+                lines.next(nextline);
                 multiline.push_back(nextline);
             }
 
-            assert(multiline.size() == lines.size());
+            ItemFilter lvals;
 
-            json                 lvals = json::array();
-            std::vector<QString> lcap;
-
-            for (size_t i = 0; i < multiline.size(); i++)
+            for (size_t i = 0; i < tails; i++)
             {
-                if (multiline[i] != lines[i])
+                std::string_view itemline = multiline[i];
+                std::string_view statline = gen.stats().continuation(entry, i);
+
+                if (itemline != statline)
                 {
                     // Try capturing values
-                    QString statline = multiline[i];
-                    captureNumerics(statline, re, lvals, lcap);
+                    propscan::readNumerics(multiline[i], lvals);
 
-                    statline.replace(re, "#");
-
-                    if (statline != lines[i])
+                    if (!propscan::matchesMasked(itemline, statline, "#"))
                     {
                         // Try the plus version
-                        statline = multiline[i];
-                        statline.replace(re, "+#");
-
-                        if (statline != lines[i])
+                        if (!propscan::matchesMasked(itemline, statline, "+#"))
                         {
                             matches = false;
                             break;
@@ -1121,111 +1582,90 @@ bool ItemAPI::parseStat(Item& item, QString stat, QTextStream& stream)
             }
 
             // Need to merge captured numerics
-            for (size_t i = 0; i < lvals.size(); i++)
+            for (size_t i = 0; i < lvals.count; i++)
             {
-                val.push_back(lvals.at(i));
+                val.push(lvals.values[i], lvals.isReal(i));
             }
-
-            captured.insert(captured.end(), lcap.begin(), lcap.end());
         }
 
-        if (!stat_type.empty())
+        if (stat_type != stat_type_known)
         {
-            if (entry["type"] != stat_type)
+            if (gen.stats().type(entry) != stat_type)
             {
                 // skip this entry
                 continue;
             }
 
+            if (ctx.mod.type != stat_type_known && discriminated(entry))
+            {
+                // Advanced copies say the type, but not the item category a stat is for
+                continue;
+            }
+
             // use crafted stat
-            filter["id"]      = entry["id"];
-            filter["type"]    = entry["type"];
-            filter["text"]    = entry["text"];
-            filter["value"]   = val;
-            filter[p_enabled] = false;
+            filter      = val;
+            filter.stat = entry;
             break;
         }
         else
         {
-            if (entry["type"] == "pseudo")
+            if (gen.stats().type(entry) == stat_pseudo)
             {
                 // skip pseudos
                 continue;
             }
 
-            std::string id = entry["id"].get<std::string>();
-
-            if (c_discriminators.contains(id) && c_discriminators[id].contains(item[p_category].get<std::string>()))
+            if (discriminated(entry))
             {
                 // Discriminator skip
                 continue;
             }
 
-            if (entry["type"] == "explicit")
+            if (gen.stats().type(entry) == stat_explicit)
             {
-                filter["id"]      = entry["id"];
-                filter["type"]    = entry["type"];
-                filter["text"]    = entry["text"];
-                filter["value"]   = val;
-                filter[p_enabled] = false;
+                filter      = val;
+                filter.stat = entry;
             }
 
             // Peek next line
-            QString peek;
-
-            int pos = stream.pos();
-
-            if (pos != -1)
-            {
-                peek = stream.read(3);
-                stream.seek(pos);
-            }
-
-            if (item[p_filters].size() < 2 && peek == "---")
+            if (item.filters.size() < 2 && lines.peek().starts_with("---"))
             {
                 // First stat with a section break, try to look for an enchant
-                if (entry["type"] == "enchant")
+                if (gen.stats().type(entry) == stat_enchant)
                 {
-                    filter["id"]      = entry["id"];
-                    filter["type"]    = entry["type"];
-                    filter["text"]    = entry["text"];
-                    filter["value"]   = val;
-                    filter[p_enabled] = false;
+                    filter      = val;
+                    filter.stat = entry;
                 }
             }
         }
     }
 
-    if (filter.empty())
+    if (filter.stat == StatTable::npos)
     {
-        qDebug() << "Error parsing stat line" << orig_stat;
+        qDebug() << "Error parsing stat line" << qstr(orig_stat);
         return false;
     }
 
-    std::string fid = filter["id"].get<std::string>();
-
     // If the item already has this filter, merge them
-    if (item[p_filters].contains(fid))
+    if (auto efil = item.filter(filter.stat))
     {
-        auto& efil = item[p_filters][fid];
-
-        auto count = efil["value"].size();
+        auto count = std::min(efil->count, filter.count);
 
         for (size_t i = 0; i < count; i++)
         {
-            if (efil["value"][i].is_number_float())
+            if (efil->isReal(i))
             {
-                efil["value"][i] = efil["value"][i].get<double>() + filter["value"][i].get<double>();
+                efil->values[i] += filter.values[i];
             }
             else
             {
-                efil["value"][i] = efil["value"][i].get<int>() + filter["value"][i].get<int>();
+                efil->values[i] = static_cast<int>(efil->values[i]) + static_cast<int>(filter.values[i]);
             }
         }
     }
     else
     {
-        item[p_filters].emplace(fid, filter);
+        item.filters.push_back(filter);
     }
 
     return true;
@@ -1338,9 +1778,9 @@ void ItemAPI::processPriceResults(json data, json response, const QString& optst
     }
 }
 
-void ItemAPI::doCurrencySearch(json& data)
+void ItemAPI::doCurrencySearch(const Item& item, json& data)
 {
-    Item& item = data[p_item];
+    auto gen = dataset();
 
     QSettings settings;
 
@@ -1360,28 +1800,30 @@ void ItemAPI::doCurrencySearch(json& data)
     std::string s_curr = settings.value(PTA_CONFIG_SECONDARY_CURRENCY, PTA_CONFIG_DEFAULT_SECONDARY_CURRENCY).toString().toStdString();
 
     // Reset setting that no longer exists
-    if (!c_currencyCodes.contains(p_curr))
+    if (!gen->currencies().containsCode(p_curr))
     {
         p_curr = PTA_CONFIG_DEFAULT_PRIMARY_CURRENCY;
         settings.setValue(PTA_CONFIG_PRIMARY_CURRENCY, QString::fromStdString(p_curr));
     }
 
-    if (!c_currencyCodes.contains(s_curr))
+    if (!gen->currencies().containsCode(s_curr))
     {
         s_curr = PTA_CONFIG_DEFAULT_SECONDARY_CURRENCY;
         settings.setValue(PTA_CONFIG_SECONDARY_CURRENCY, QString::fromStdString(s_curr));
     }
 
     // Check for existing currencies
-    if (!c_currencyMap.contains(item[p_type]))
+    CurrencyTable::index_t currency = gen->currencies().find(item.type);
+
+    if (currency == CurrencyTable::npos)
     {
         emit humour(tr("Could not find this currency in the database. See log for details."));
-        qWarning() << "Currency not found:" << QString::fromStdString(item[p_type]);
+        qWarning() << "Currency not found:" << QString::fromStdString(item.type);
         qWarning() << "If you believe that this is a mistake, please file a bug report on GitHub.";
         return;
     }
 
-    std::string want = c_currencyMap[item[p_type].get<std::string>()].get<std::string>();
+    std::string want(gen->currencies().code(currency));
     std::string have = p_curr;
 
     if (want == p_curr)
@@ -1405,9 +1847,9 @@ void ItemAPI::doCurrencySearch(json& data)
         request.setRawHeader("Content-Type", "application/json");
 
         QEventLoop loop;
-        connect(m_manager, &QNetworkAccessManager::finished, &loop, &QEventLoop::quit);
 
         auto req = m_manager->post(request, QByteArray::fromStdString(qba));
+        connect(req, &QNetworkReply::finished, &loop, &QEventLoop::quit);
         loop.exec();
 
         req->deleteLater();
@@ -1460,9 +1902,9 @@ void ItemAPI::doCurrencySearch(json& data)
 bool ItemAPI::synchronizedGetJSON(const QNetworkRequest& req, json& result)
 {
     QEventLoop loop;
-    connect(m_manager, &QNetworkAccessManager::finished, &loop, &QEventLoop::quit);
 
     auto reply = m_manager->get(req);
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
     loop.exec();
 
     reply->deleteLater();
@@ -1491,12 +1933,14 @@ bool ItemAPI::synchronizedGetJSON(const QNetworkRequest& req, json& result)
 
 QString ItemAPI::getLeague()
 {
+    auto gen = dataset();
+
     QSettings settings;
     int       league = settings.value(PTA_CONFIG_LEAGUE, PTA_CONFIG_DEFAULT_LEAGUE).toInt();
 
-    if (league > m_leagues.size())
+    if (league > gen->leagues().size())
     {
-        QString defleag = QString::fromStdString(m_leagues[PTA_CONFIG_DEFAULT_LEAGUE].get<std::string>());
+        QString defleag = QString::fromStdString(gen->leagues()[PTA_CONFIG_DEFAULT_LEAGUE].get<std::string>());
 
         qWarning() << "Previously set league no longer available. Resetting to default league" << defleag;
 
@@ -1504,195 +1948,300 @@ QString ItemAPI::getLeague()
         settings.setValue(PTA_CONFIG_LEAGUE, PTA_CONFIG_DEFAULT_LEAGUE);
     }
 
-    return QString::fromStdString(m_leagues[league].get<std::string>());
+    return QString::fromStdString(gen->leagues()[league].get<std::string>());
+}
+
+ItemAPI::ParseContext ItemAPI::parseContext() const
+{
+    ParseContext ctx;
+
+    // Pin the current generation for the whole parse
+    ctx.gen        = dataset();
+    ctx.loaded     = ctx.gen->loaded();
+    ctx.statsReady = tierLoaded(ctx.loaded, tier_stats);
+
+    // Fingerprints of the tables that are in, so equal keys mean equal parses
+    std::array<uint64_t, table_max + 1> key = {};
+
+    for (uint32_t t = 0; t < table_max; t++)
+    {
+        if (ctx.has(static_cast<dataset_table>(t)))
+        {
+            key[t] = ctx.gen->fingerprints[t];
+        }
+    }
+
+    key[table_max] = ctx.loaded;
+    ctx.dataKey    = ptadb::hash(reinterpret_cast<const char*>(key.data()), sizeof(key));
+
+    return ctx;
+}
+
+bool ItemAPI::parse(Item& item, QString itemText) const
+{
+    ParseContext ctx  = parseContext();
+    uint64_t     text = ParseCache::textHash(itemText);
+
+    if (m_parseCache.find(text, ctx.dataKey, ctx.gen, item))
+    {
+        // Only the note can differ
+        item.origtext = itemText.toStdString();
+        return true;
+    }
+
+    uint64_t allocs = alloccount::thread();
+
+    if (!parseItem(ctx, item, itemText))
+    {
+        return false;
+    }
+
+    if (alloccount::enabled)
+    {
+        qDebug() << "Parsed item with" << (alloccount::thread() - allocs) << "allocations";
+    }
+
+    m_parseCache.insert(text, ctx.dataKey, item);
+
+    return true;
+}
+
+std::vector<std::optional<Item>> ItemAPI::parseBatch(const QStringList& itemTexts) const
+{
+    ParseContext shared = parseContext();
+
+    shared.deferPseudos = true;
+
+    std::vector<std::optional<Item>> items(itemTexts.size());
+    std::vector<int>                 indices(itemTexts.size());
+
+    std::iota(indices.begin(), indices.end(), 0);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QtConcurrent::blockingMap(indices, [&](int i) {
+        ParseContext ctx = shared;
+        Item         item;
+
+        if (parseItem(ctx, item, itemTexts[i]))
+        {
+            items[i] = std::move(item);
+        }
+    });
+
+    std::vector<Item*> parsed;
+
+    for (auto& item : items)
+    {
+        if (item)
+        {
+            parsed.push_back(&*item);
+        }
+    }
+
+    Item::computePseudos(parsed);
+
+    StatMissCache::counts misses = statMissCounts();
+
+    qDebug() << "Parsed" << itemTexts.size() << "items in" << timer.elapsed() << "ms," << misses.hits << "unmatchable stat lines skipped so far";
+
+    return items;
 }
 
-bool ItemAPI::parse(Item& item, QString itemText)
+bool ItemAPI::parseItem(ParseContext& ctx, Item& item, const QString& itemText) const
 {
-    QTextStream stream(&itemText, QIODevice::ReadOnly);
-    QString     line;
-    int         sections = 0;
+    const auto& gen = ctx.gen;
+
+    // Full original text. The parser works on views into it, or into the copy
+    // an advanced copy is read from, from here on
+    item.origtext = itemText.toStdString();
+
+    std::string_view text = item.origtext;
+    std::string      work;
+
+    // Advanced copies put a header in front of every mod, and the rolls of a
+    // mod after its values
+    ctx.advanced = (text.find("\n{ ") != std::string_view::npos);
+
+    if (ctx.advanced)
+    {
+        work = item.origtext;
+        work.resize(propscan::stripRolls(work.data(), work.size()));
+        text = work;
+    }
+
+    propscan::LineReader lines(text);
+    std::string_view     line;
+    int                  sections = 0;
 
     // Check first line for PoE item
-    stream.readLineInto(&line);
+    lines.next(line);
+
+    // Newer clients lead with the item class
+    if (line.starts_with("Item Class:"))
+    {
+        lines.next(line);
+    }
 
-    if (!line.startsWith("Rarity:"))
+    if (!line.starts_with("Rarity:"))
     {
         qWarning() << "Parse called on non PoE item text";
         return false;
     }
 
-    // Full original text
-    item[p_origtext] = itemText.toStdString();
+    item.gen = gen;
 
     // Rarity
-    item[p_rarity] = line.section(": ", 1, 1).toStdString();
+    item.rarity = readRarity(propValue(line));
+
+    // The named affixes are needed up front to cut them off a magic name
+    if (ctx.advanced)
+    {
+        propscan::LineReader headers(text);
+        std::string_view     l;
+
+        while (headers.next(l))
+        {
+            if (!l.starts_with("{ "))
+            {
+                continue;
+            }
+
+            auto mod = readModHeader(ctx, l);
+
+            if (!mod.affix.empty() && mod.generation != mod_generation_type::mod_unknown)
+            {
+                ctx.affixes.push_back(mod);
+            }
+        }
+    }
 
     // Read name/type
-    QString nametype, type;
-    stream.readLineInto(&nametype);
-    stream.readLineInto(&type);
+    std::string_view nametype, type;
+    lines.next(nametype);
+    lines.next(type);
 
-    if (nametype.startsWith("You cannot"))
+    if (nametype.starts_with("You cannot"))
     {
         // Item requirements not met msg (why is this needed GGG?!)
         // Ignore it and read the subsequent lines
-        stream.readLineInto(&nametype);
-        stream.readLineInto(&type);
+        lines.next(nametype);
+        lines.next(type);
     }
 
-    if (type.startsWith("---"))
+    if (type.starts_with("---"))
     {
         // nametype has to be item type and not name
-        item[p_type] = readType(item, nametype);
+        item.type = readType(ctx, item, nametype);
         sections++;
     }
     else
     {
-        item[p_name] = readName(nametype);
-        item[p_type] = readType(item, type);
+        item.name = readName(nametype);
+        item.type = readType(ctx, item, type);
+        item.set(field_name);
     }
 
     // Process category
-    if ("Gem" == item[p_rarity].get<std::string>())
+    if (item.rarity == rarity_gem)
     {
-        item[p_category] = "gem";
+        item.category = cat_gem;
 
         // Initialize quality
-        item[p_quality] = 0;
+        item.quality = 0;
+        item.set(field_quality);
     }
-    else if ("Divination Card" == item[p_rarity].get<std::string>())
+    else if (item.rarity == rarity_card)
     {
-        item[p_category] = item[p_rarity] = "card";
+        item.category = cat_card;
     }
 
-    if (item[p_type].get<std::string>().ends_with("Map"))
+    if (item.type.ends_with("Map"))
     {
-        item[p_category] = "map";
-        item[p_mdisc]    = m_mapdisc; // Default map discriminator
+        item.category  = cat_map;
+        item.misc.disc = m_mapdisc; // Default map discriminator
+        item.set(field_misc_disc);
 
-        item[p_type] = std::regex_replace(item[p_type].get<std::string>(), std::regex("Elder "), "");
-        item[p_type] = std::regex_replace(item[p_type].get<std::string>(), std::regex("Shaped "), "");
+        eraseAll(item.type, "Elder ");
+        eraseAll(item.type, "Shaped ");
     }
 
-    if (!item.contains(p_category) && m_uniques.contains(item[p_type].get<std::string>()))
+    if (item.category == cat_none && ctx.has(table_uniques) && gen->uniques().find(item.type, "Prophecy") != UniqueTable::npos)
     {
-        auto search = m_uniques.find(item[p_type]);
-        if (search != m_uniques.end())
-        {
-            auto& je = search->second;
-            if (je["type"] == "Prophecy")
-            {
-                // this is a prophecy
-                item[p_name]     = item[p_type];
-                item[p_type]     = "Prophecy";
-                item[p_category] = "prophecy";
-            }
-        }
+        // this is a prophecy
+        item.name     = item.type;
+        item.type     = "Prophecy";
+        item.category = cat_prophecy;
+        item.set(field_name);
     }
 
-    if (!item.contains(p_category))
+    if (item.category == cat_none && ctx.has(table_bases))
     {
-        auto base = c_baseMap.find(item[p_type].get<std::string>());
-        if (base != c_baseMap.end())
+        item.base = gen->bases().find(item.type);
+
+        if (item.base != BaseTable::npos)
         {
-            json cat         = base->second;
-            item[p_category] = cat["category"];
+            item.category = gen->bases().category(item.base);
         }
     }
 
+    // Lets bulk currency be checked before the base tables are in
+    if (item.category == cat_none && item.rarity == rarity_currency)
+    {
+        item.category = cat_currency;
+    }
+
     // Read the rest of the crap
 
-    while (stream.readLineInto(&line))
+    while (lines.next(line))
     {
         // Skip
-        if (line.startsWith("---"))
+        if (line.starts_with("---"))
         {
-            m_section.clear();
+            ctx.requirements = false;
+            ctx.mod          = ParseContext::ModHeader();
             sections++;
             continue;
         }
 
-        if (line.contains(":"))
+        if (ctx.advanced)
+        {
+            if (line.starts_with("{ "))
+            {
+                ctx.mod = readModHeader(ctx, line);
+                continue;
+            }
+
+            // Reminder text
+            if (line.starts_with('(') && line.ends_with(')'))
+            {
+                continue;
+            }
+        }
+
+        if (size_t colon = line.find(':'); colon != std::string_view::npos)
         {
             // parse item prop
-            parseProp(item, line);
+            parseProp(ctx, item, line.substr(0, colon), propValue(line));
         }
-        else if (sections > 1)
+        else if (sections > 1 && ctx.statsReady)
         {
             // parse item stat
-            parseStat(item, line, stream);
+            parseStat(ctx, item, line, lines);
         }
     }
 
-    // Process special/pseudo rules
-    if (item[p_filters].size())
+    // Process special/pseudo rules. A batch sums them up for all of its items at once
+    if (!ctx.deferPseudos)
     {
-        for (const auto [key, fil] : item[p_filters].items())
-        {
-            if (c_pseudoRules.contains(key))
-            {
-                const auto& rules = c_pseudoRules[key];
-
-                for (const auto& r : rules)
-                {
-                    std::string pid = r["id"].get<std::string>();
-
-                    auto pentry = m_stats_by_id[pid];
-
-                    if (!item[p_pseudos].contains(pid))
-                    {
-                        json ps_entry = pentry;
-
-                        ps_entry[p_enabled] = false;
-                        ps_entry["value"]   = json::array();
-
-                        for (const auto v : fil["value"])
-                        {
-                            if (v.is_number_float())
-                            {
-                                ps_entry["value"].push_back(v.get<double>() * r["factor"].get<double>());
-                            }
-                            else
-                            {
-                                ps_entry["value"].push_back((int) (v.get<int>() * r["factor"].get<double>()));
-                            }
-                        }
-
-                        item[p_pseudos].emplace(pid, ps_entry);
-                    }
-                    else
-                    {
-                        auto& ps_entry = item[p_pseudos][pid];
-
-                        for (size_t i = 0; i < fil["value"].size(); i++)
-                        {
-                            auto v = fil["value"][i];
-
-                            // XXX: only support one operation right now
-                            // also remove is useless
-                            if (r["op"] == "add")
-                            {
-                                if (v.is_number_float())
-                                {
-                                    ps_entry["value"][i] = ps_entry["value"][i].get<double>() + (v.get<double>() * r["factor"].get<double>());
-                                }
-                                else
-                                {
-                                    ps_entry["value"][i] = ps_entry["value"][i].get<int>() + ((int) (v.get<int>() * r["factor"].get<double>()));
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        item.computePseudos();
     }
 
     return true;
 }
 
-void ItemAPI::fillItemOptions(json& data)
+void ItemAPI::fillItemOptions(const Item& item, json& data)
 {
     QSettings settings;
 
@@ -1742,31 +2291,34 @@ void ItemAPI::fillItemOptions(json& data)
     data[p_opts]["use_links"]     = false;
     data[p_opts]["use_ilvl"]      = prefillilvl;
     data[p_opts]["use_item_base"] = prefillbase;
-    data[p_opts]["use_corrupted"] = ((data[p_item].contains(p_corrupted) && data[p_item][p_corrupted].get<bool>()) ? "Yes" : "Any");
+    data[p_opts]["use_corrupted"] = (item.has(field_corrupted) ? "Yes" : "Any");
 
     if (prefillbase)
     {
-        if (data[p_item].contains(p_influences))
+        for (size_t i = 0; i < influences_max; i++)
         {
-            data[p_opts][p_influences] = data[p_item][p_influences];
+            if (item.influences.test(i))
+            {
+                data[p_opts][p_influences].push_back(Item::influence_names[i]);
+            }
         }
 
-        if (data[p_item].contains(p_msynth) && data[p_item][p_msynth].get<bool>())
+        if (item.has(field_misc_synthesis))
         {
             data[p_opts]["use_synthesis_base"] = prefillbase;
         }
     }
 }
 
-bool ItemAPI::trySimplePriceCheck(json& data)
+bool ItemAPI::trySimplePriceCheck(const Item& item, json& data)
 {
-    Item& item = data[p_item];
+    auto gen = dataset();
 
     // If its a currency and the currency is listed in the bulk exchange, try that first
     // Otherwise, try a regular search
-    if (item[p_category] == "currency" && c_currencyMap.contains(item[p_type]))
+    if (item.category == cat_currency && gen->currencies().find(item.type) != CurrencyTable::npos)
     {
-        doCurrencySearch(data);
+        doCurrencySearch(item, data);
         return true;
     }
 
@@ -1806,30 +2358,27 @@ bool ItemAPI::trySimplePriceCheck(json& data)
     }
 
     // Search by type if rare map, or if it has no name
-    if ((item[p_category] == "map" && item[p_rarity] == "Rare") || !item.contains(p_name))
+    if ((item.category == cat_map && item.rarity == rarity_rare) || !item.has(field_name))
     {
-        is_unique_base = m_uniques.contains(item[p_type]);
-        searchToken    = item[p_type];
+        is_unique_base = gen->uniques().contains(item.type);
+        searchToken    = item.type;
     }
     else
     {
-        is_unique_base = m_uniques.contains(item[p_name]);
-        searchToken    = item[p_name];
+        is_unique_base = gen->uniques().contains(item.name);
+        searchToken    = item.name;
     }
 
     // Force rarity if unique
-    if (item[p_rarity] == "Unique")
+    if (item.rarity == rarity_unique)
     {
-        std::string rarity = item[p_rarity];
-        std::transform(rarity.begin(), rarity.end(), rarity.begin(), ::tolower);
-
-        query["query"]["filters"]["type_filters"]["filters"]["rarity"]["option"] = rarity;
+        query["query"]["filters"]["type_filters"]["filters"]["rarity"]["option"] = "unique";
     }
 
     // Force category
-    if (item.contains(p_category))
+    if (item.category != cat_none)
     {
-        std::string category = item[p_category];
+        std::string category(item.categoryName());
         std::transform(category.begin(), category.end(), category.begin(), ::tolower);
 
         query["query"]["filters"]["type_filters"]["filters"]["category"]["option"] = category;
@@ -1840,95 +2389,96 @@ bool ItemAPI::trySimplePriceCheck(json& data)
     {
         auto& qe = query["query"];
 
-        auto range = m_uniques.equal_range(searchToken);
-        for (auto it = range.first; it != range.second; ++it)
+        const auto&        uniques = gen->uniques();
+        const std::string& type    = item.type;
+
+        // If has discriminator, match discriminator and type
+        if (item.has(field_misc_disc))
         {
-            auto& entry = it->second;
+            const std::string& disc  = item.misc.disc;
+            auto               entry = uniques.find(searchToken, type, disc);
 
-            // If has discriminator, match discriminator and type
-            if (item.contains(p_misc) && item.contains(p_mdisc))
+            if (entry != UniqueTable::npos)
             {
-                if (entry["disc"] == item[p_mdisc] && entry["type"] == item[p_type])
+                if (uniques.hasName(entry))
                 {
-                    if (entry.contains("name"))
-                    {
-                        qe["name"] = {{"discriminator", entry["disc"]}, {"option", entry["name"]}};
-                    }
-
-                    qe["type"] = {{"discriminator", entry["disc"]}, {"option", entry["type"]}};
-
-                    break;
+                    qe["name"] = {{"discriminator", disc}, {"option", uniques.name(entry)}};
                 }
-            }
-            else if (entry["type"] == item[p_type])
-            {
-                // For everything else, just match type
-                qe["type"] = entry["type"];
 
-                if (entry.contains("name"))
-                {
-                    qe["name"] = entry["name"];
-                }
+                qe["type"] = {{"discriminator", disc}, {"option", type}};
+            }
+        }
+        else if (auto entry = uniques.find(searchToken, type); entry != UniqueTable::npos)
+        {
+            // For everything else, just match type
+            qe["type"] = type;
 
-                break;
+            if (uniques.hasName(entry))
+            {
+                qe["name"] = uniques.name(entry);
             }
         }
 
         QString options = getLeague();
 
         // Default Gem options
-        if (item[p_category] == "gem")
+        if (item.category == cat_gem)
         {
-            qe["filters"]["misc_filters"]["filters"]["gem_level"]["min"] = item[p_mglvl];
-            qe["filters"]["misc_filters"]["filters"]["quality"]["min"]   = item[p_quality];
+            qe["filters"]["misc_filters"]["filters"]["gem_level"]["min"] = item.misc.gemLevel;
+            qe["filters"]["misc_filters"]["filters"]["quality"]["min"]   = item.quality;
 
-            options += ", Lv" + QString::number(item[p_mglvl].get<int>()) + "/" + QString::number(item[p_quality].get<int>()) + "%";
+            options += ", Lv" + QString::number(item.misc.gemLevel) + "/" + QString::number(item.quality) + "%";
         }
 
         // Default socket options
-        if (item.contains(p_sockets) && item[p_sockets]["total"] == 6)
+        if (item.has(field_sockets) && item.sockets.total == 6)
         {
-            qe["filters"]["socket_filters"]["filters"]["sockets"]["min"] = item[p_sockets]["total"];
+            qe["filters"]["socket_filters"]["filters"]["sockets"]["min"] = item.sockets.total;
 
-            options += ", " + QString::number(item[p_sockets]["total"].get<int>()) + "S";
+            options += ", " + QString::number(item.sockets.total) + "S";
         }
 
         // Default link options
-        if (item.contains(p_sockets) && item[p_sockets]["links"] > 4)
+        if (item.has(field_sockets) && item.sockets.links > 4)
         {
-            qe["filters"]["socket_filters"]["filters"]["links"]["min"] = item[p_sockets]["links"];
+            qe["filters"]["socket_filters"]["filters"]["links"]["min"] = item.sockets.links;
 
-            options += ", " + QString::number(item[p_sockets]["links"].get<int>()) + "L";
+            options += ", " + QString::number(item.sockets.links) + "L";
         }
 
         // Force iLvl
-        if (item[p_rarity] != "Unique" && item[p_category] != "card" && item.contains(p_ilvl))
+        if (item.rarity != rarity_unique && item.category != cat_card && item.has(field_ilvl))
         {
-            qe["filters"]["misc_filters"]["filters"]["ilvl"]["min"] = item[p_ilvl];
+            qe["filters"]["misc_filters"]["filters"]["ilvl"]["min"] = item.ilvl;
 
-            options += ", iLvl=" + QString::number(item[p_ilvl].get<int>());
+            options += ", iLvl=" + QString::number(item.ilvl);
         }
 
         // Force map tier
-        if (item[p_category] == "map" && item.contains(p_mmtier))
+        if (item.category == cat_map && item.has(field_misc_map_tier))
         {
-            qe["filters"]["map_filters"]["filters"]["map_tier"]["min"] = item[p_mmtier];
+            qe["filters"]["map_filters"]["filters"]["map_tier"]["min"] = item.misc.mapTier;
 
-            options += ", Map Tier=" + QString::number(item[p_mmtier].get<int>());
+            options += ", Map Tier=" + QString::number(item.misc.mapTier);
         }
 
         // Note discriminator
-        if (item.contains(p_mdisc))
+        if (item.has(field_misc_disc))
         {
-            options += ", Disc=" + QString::fromStdString(item[p_mdisc].get<std::string>());
+            options += ", Disc=" + QString::fromStdString(item.misc.disc);
         }
 
         // Force Influences
-        if (item[p_category] != "card" && item.contains(p_influences))
+        if (item.category != cat_card)
         {
-            for (auto i : item[p_influences])
+            for (size_t i = 0; i < influences_max; i++)
             {
-                std::string inf     = i.get<std::string>();
+                if (!item.influences.test(i))
+                {
+                    continue;
+                }
+
+                std::string inf     = Item::influence_names[i];
                 std::string inftype = inf + "_item";
 
                 qe["filters"]["misc_filters"]["filters"][inftype]["option"] = true;
@@ -1939,7 +2489,7 @@ bool ItemAPI::trySimplePriceCheck(json& data)
         }
 
         // Force Synthesis
-        if (item.contains(p_msynth))
+        if (item.has(field_misc_synthesis))
         {
             qe["filters"]["misc_filters"]["filters"]["synthesised_item"]["option"] = true;
             options += ", Synthesis Base";
@@ -1949,7 +2499,7 @@ bool ItemAPI::trySimplePriceCheck(json& data)
         bool corrupt_override = settings.value(PTA_CONFIG_CORRUPTOVERRIDE, PTA_CONFIG_DEFAULT_CORRUPTOVERRIDE).toBool();
 
         // No such thing as corrupted cards or prophecies
-        if (item[p_category] != "card" && item[p_category] != "prophecy")
+        if (item.category != cat_card && item.category != cat_prophecy)
         {
             if (corrupt_override)
             {
@@ -1970,10 +2520,10 @@ bool ItemAPI::trySimplePriceCheck(json& data)
             }
             else
             {
-                qe["filters"]["misc_filters"]["filters"]["corrupted"]["option"] = item.contains(p_corrupted) && item[p_corrupted].get<bool>();
+                qe["filters"]["misc_filters"]["filters"]["corrupted"]["option"] = item.has(field_corrupted);
 
                 options += ", Corrupted=";
-                options += (item.contains(p_corrupted) && item[p_corrupted].get<bool>()) ? "Yes" : "No";
+                options += item.has(field_corrupted) ? "Yes" : "No";
             }
         }
 
@@ -2027,11 +2577,11 @@ bool ItemAPI::trySimplePriceCheck(json& data)
 
         return true;
     }
-    else if (item[p_rarity] != "Magic")
+    else if (item.rarity != rarity_magic)
     {
         // poeprices.info
 
-        QString itemText = QString::fromStdString(item[p_origtext]);
+        QString itemText = QString::fromStdString(item.origtext);
 
         itemText.remove(QRegularExpression("<<.*?>>|<.*?>"));
 
@@ -2106,17 +2656,19 @@ bool ItemAPI::trySimplePriceCheck(json& data)
 
 void ItemAPI::advancedPriceCheck(const QString& str, bool openonsite)
 {
-    json  data = json::parse(str.toStdString());
-    Item& item = data[p_item];
+    auto gen = dataset();
+
+    json data = json::parse(str.toStdString());
+    Item item = Item::fromJson(data[p_item], gen);
 
-    if (!item.contains(p_filters) || item[p_category] == "map")
+    if (item.filters.empty() || item.category == cat_map)
     {
         // Cannot advanced search items with no filters
         emit humour(tr("Advanced search is unavailable for this item type"));
         return;
     }
 
-    if (item.contains(p_unidentified))
+    if (item.has(field_unidentified))
     {
         emit humour(tr("Advanced search is unavailable for unidentified items"));
         return;
@@ -2158,32 +2710,24 @@ void ItemAPI::advancedPriceCheck(const QString& str, bool openonsite)
     bool        is_unique_base = false;
     std::string searchToken;
 
-    if (item.contains(p_name))
+    if (item.has(field_name))
     {
-        is_unique_base = m_uniques.contains(item[p_name]);
-        searchToken    = item[p_name];
+        is_unique_base = gen->uniques().contains(item.name);
+        searchToken    = item.name;
     }
     else
     {
-        is_unique_base = m_uniques.contains(item[p_type]);
-        searchToken    = item[p_type];
+        is_unique_base = gen->uniques().contains(item.type);
+        searchToken    = item.type;
     }
 
     // Force rarity
-    std::string rarity = "nonunique";
-
-    if (item[p_rarity] == "Unique")
-    {
-        rarity = item[p_rarity];
-        std::transform(rarity.begin(), rarity.end(), rarity.begin(), ::tolower);
-    }
-
-    query["query"]["filters"]["type_filters"]["filters"]["rarity"]["option"] = rarity;
+    query["query"]["filters"]["type_filters"]["filters"]["rarity"]["option"] = (item.rarity == rarity_unique ? "unique" : "nonunique");
 
     // Force category
-    if (item.contains(p_category))
+    if (item.category != cat_none)
     {
-        std::string category = item[p_category];
+        std::string category(item.categoryName());
         std::transform(category.begin(), category.end(), category.begin(), ::tolower);
 
         query["query"]["filters"]["type_filters"]["filters"]["category"]["option"] = category;
@@ -2257,38 +2801,28 @@ void ItemAPI::advancedPriceCheck(const QString& str, bool openonsite)
     }
 
     // Checked mods
-    for (auto& [k, e] : item[p_filters].items())
+    for (const auto& f : item.filters)
     {
-        // set id
-        e["id"] = k;
-
-        if (e[p_enabled] == true)
+        if (f.enabled)
         {
-            e["disabled"] = false;
-            e.erase(p_enabled);
-            qe["stats"][0]["filters"].push_back(e);
+            qe["stats"][0]["filters"].push_back(f.toQueryJson(gen->stats()));
         }
     }
 
     // Check for unique items
     if (is_unique_base)
     {
-        auto range = m_uniques.equal_range(searchToken);
-        for (auto it = range.first; it != range.second; ++it)
+        const auto&        uniques = gen->uniques();
+        const std::string& type    = item.type;
+
+        // For everything else, match type
+        if (auto entry = uniques.find(searchToken, type); entry != UniqueTable::npos)
         {
-            auto& entry = it->second;
+            qe["type"] = type;
 
-            // For everything else, match type
-            if (entry["type"] == item[p_type])
+            if (uniques.hasName(entry))
             {
-                qe["type"] = entry["type"];
-
-                if (entry.contains("name"))
-                {
-                    qe["name"] = entry["name"];
-                }
-
-                break;
+                qe["name"] = uniques.name(entry);
             }
         }
     }
@@ -2298,31 +2832,31 @@ void ItemAPI::advancedPriceCheck(const QString& str, bool openonsite)
     // Use sockets
     if (data[p_usesockets].get<bool>())
     {
-        qe["filters"]["socket_filters"]["filters"]["sockets"]["min"] = item[p_sockets]["total"];
+        qe["filters"]["socket_filters"]["filters"]["sockets"]["min"] = item.sockets.total;
 
-        options += ", " + QString::number(item[p_sockets]["total"].get<int>()) + "S";
+        options += ", " + QString::number(item.sockets.total) + "S";
     }
 
     // Use links
     if (data[p_uselinks].get<bool>())
     {
-        qe["filters"]["socket_filters"]["filters"]["links"]["min"] = item[p_sockets]["links"];
+        qe["filters"]["socket_filters"]["filters"]["links"]["min"] = item.sockets.links;
 
-        options += ", " + QString::number(item[p_sockets]["links"].get<int>()) + "L";
+        options += ", " + QString::number(item.sockets.links) + "L";
     }
 
     // Use iLvl
     if (data[p_useilvl].get<bool>())
     {
-        qe["filters"]["misc_filters"]["filters"]["ilvl"]["min"] = item[p_ilvl];
+        qe["filters"]["misc_filters"]["filters"]["ilvl"]["min"] = item.ilvl;
 
-        options += ", iLvl=" + QString::number(item[p_ilvl].get<int>());
+        options += ", iLvl=" + QString::number(item.ilvl);
     }
 
     // Use item base
     if (data[p_usebase].get<bool>())
     {
-        qe["type"] = item[p_type];
+        qe["type"] = item.type;
 
         options += ", Use Base Type";
     }
@@ -2425,17 +2959,17 @@ void ItemAPI::openWiki(const Item& item)
 {
     QString itemName;
 
-    if (item[p_rarity].get<std::string>() == "Rare")
+    if (item.rarity == rarity_rare)
     {
-        itemName = QString::fromStdString(item[p_type].get<std::string>());
+        itemName = QString::fromStdString(item.type);
     }
-    else if (item.contains(p_name))
+    else if (item.has(field_name))
     {
-        itemName = QString::fromStdString(item[p_name].get<std::string>());
+        itemName = QString::fromStdString(item.name);
     }
     else
     {
-        itemName = QString::fromStdString(item[p_type].get<std::string>());
+        itemName = QString::fromStdString(item.type);
     }
 
     itemName = itemName.replace(" ", "_");
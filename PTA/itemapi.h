@@ -1,62 +1,149 @@
 #pragma once
 
+#include "dataset.h"
+#include "misscache.h"
+#include "parsecache.h"
 #include "pitem.h"
+#include "propscan.h"
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <optional>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 
 #include <nlohmann/json.hpp>
 
-#include <QMap>
+#include <QFuture>
 #include <QNetworkAccessManager>
 #include <QObject>
-#include <QTextStream>
-#include <QVector>
+#include <QStringList>
+#include <QTimer>
 
 using json = nlohmann::json;
 
+// Datasets become usable in tiers so price checks can start before everything is loaded.
+// Each tier includes the ones before it.
+enum data_tier : uint8_t
+{
+    tier_core = 0, // leagues, currency
+    tier_stats,    // trade stats, uniques and the PTA stat rules
+    tier_bases,    // RePoE bases and their categories
+    tier_full,     // RePoE mods, only magic items need them to split their name
+    tier_max
+};
+
 class ItemAPI : public QObject
 {
     Q_OBJECT
 
 public:
     ItemAPI(QNetworkAccessManager* netmanager, QObject* parent = nullptr);
+    ~ItemAPI();
+
+    bool isReady(data_tier tier) const;
 
-    const json getLeagues() { return m_leagues; }
+    // Blocks in a local event loop until the tier is loaded. Returns false if loading failed
+    bool waitForTier(data_tier tier);
+
+    // Lowest tier an item can be parsed and priced with
+    data_tier requiredTier(const QString& itemText) const;
+
+    const json getLeagues() { return dataset()->leagues(); }
     QString    getLeague();
 
-    bool parse(Item& item, QString itemText);
-    void fillItemOptions(json& data);
+    bool parse(Item& item, QString itemText) const;
+
+    // Parses every text on the global thread pool against one dataset generation.
+    // Entries that fail to parse are left empty
+    std::vector<std::optional<Item>> parseBatch(const QStringList& itemTexts) const;
+
+    // How many stat lines were dropped as known misses, and how many were looked up
+    StatMissCache::counts statMissCounts() const { return m_statMisses.counters(); }
+
+    void fillItemOptions(const Item& item, json& data);
 
     void openWiki(const Item& item);
 
-    bool trySimplePriceCheck(json& data);
+    bool trySimplePriceCheck(const Item& item, json& data);
 
 public slots:
     void advancedPriceCheck(const QString& str, bool openonsite);
 
+    // Builds the next dataset generation in the background and publishes it if anything changed
+    void refreshData();
+
 signals:
+    void tierReady(data_tier tier);
+    void loadFailed(const QString& error);
+
     void humour(const QString& msg);
     void simpleResultsFinished(const QString& results);
     void priceCheckFinished(const QString& results);
 
+private slots:
+    void handleDatasetLoaded(const QString& name);
+    void handleLoadFinished();
+    void handleSnapshotRestored(bool restored);
+
 private:
-    int         readPropInt(QString prop);
-    json        readPropIntRange(QString prop);
-    double      readPropFloat(QString prop);
-    json        readSockets(QString prop);
-    std::string readName(QString name);
-    std::string readType(Item& item, QString type);
+    void startLoad();
+    void restoreSnapshot();
+    void fetchSources();
 
-    void captureNumerics(QString line, QRegularExpression& re, json& val, std::vector<QString>& captured);
+    // Publishes a generation with the given tables of the first load added, bit per dataset_table
+    void publishTables(uint32_t tables);
 
-    void parseProp(Item& item, QString prop);
-    bool parseStat(Item& item, QString stat, QTextStream& stream);
+    // Current dataset generation. Hold on to the result for as long as the tables are in use
+    std::shared_ptr<const Dataset> dataset() const { return m_data.load(); }
+
+    // State of a single parse. Everything else the parser reads is immutable,
+    // so any number of parses can run at once
+    struct ParseContext
+    {
+        // Header an advanced copy (Ctrl+Alt+C) puts in front of every mod, e.g.
+        // { Prefix Modifier "Robust" (Tier: 5) — Life }
+        struct ModHeader
+        {
+            stat_type_e         type       = stat_type_known; // none
+            mod_generation_type generation = mod_generation_type::mod_unknown;
+            std::string_view    affix; // view into the item text, valid during parseItem
+        };
+
+        std::shared_ptr<const Dataset> gen;
+        uint32_t                       loaded       = 0; // tables of gen, bit per dataset_table
+        uint64_t                       dataKey      = 0; // identifies the loaded tables, see ParseCache and StatMissCache
+        bool                           statsReady   = false;
+        bool                           requirements = false; // reading the "Requirements:" section
+
+        bool                   advanced = false; // item text is an advanced copy
+        ModHeader              mod;              // header of the mod being read
+        std::vector<ModHeader> affixes;          // every named prefix and suffix of the item
+
+        bool deferPseudos = false; // pseudos are left to the caller, see Item::computePseudos
+
+        bool has(dataset_table table) const { return (loaded & (1u << table)); }
+    };
+
+    ParseContext parseContext() const;
+
+    bool parseItem(ParseContext& ctx, Item& item, const QString& itemText) const;
+
+    std::string readName(std::string_view name) const;
+    std::string readType(const ParseContext& ctx, Item& item, std::string_view line) const;
+
+    ParseContext::ModHeader readModHeader(const ParseContext& ctx, std::string_view line) const;
+
+    std::string maskNumerics(std::string_view line, std::string_view mask) const;
+
+    void parseProp(ParseContext& ctx, Item& item, std::string_view p, std::string_view v) const;
+    bool parseStat(const ParseContext& ctx, Item& item, std::string_view stat, propscan::LineReader& lines) const;
 
     void processPriceResults(json data, json response, const QString& optstr, const QString& format);
 
-    void doCurrencySearch(json& data);
+    void doCurrencySearch(const Item& item, json& data);
 
     bool synchronizedGetJSON(const QNetworkRequest& req, json& result);
 
@@ -113,75 +200,66 @@ private:
         misc_filter_map_tier
     };
 
-    enum misc_influences_e : uint8_t
+    enum special_filters_e : uint8_t
     {
-        shaper = 0,
-        elder,
-        crusader,
-        redeemer,
-        hunter,
-        warlord,
-        influences_max
+        special_filter_requirements = 0,
+        special_filter_level
     };
 
-    enum class mod_generation_type : uint8_t
+    // Filter group and filter a property line sets, by property name
+    struct prop_entry
     {
-        mod_prefix = 0,
-        mod_suffix,
-        mod_unknown
+        filter_type_e type;
+        uint8_t       filter;
     };
 
-    const std::array<std::string, influences_max> c_influenceMap = {"shaper", "elder", "crusader", "redeemer", "hunter", "warlord"};
-
-    const QMap<QString, QVector<uint8_t>> c_propMap = {{"Quality", {misc_filter, misc_filter_quality}},
-                                                       {"Quality (Elemental Damage)", {misc_filter, misc_filter_quality}},
-                                                       {"Quality (Caster Modifiers)", {misc_filter, misc_filter_quality}},
-                                                       {"Quality (Attack Modifiers)", {misc_filter, misc_filter_quality}},
-                                                       {"Quality (Defence Modifiers)", {misc_filter, misc_filter_quality}},
-                                                       {"Quality (Life and Mana Modifiers)", {misc_filter, misc_filter_quality}},
-                                                       {"Quality (Resistance Modifiers)", {misc_filter, misc_filter_quality}},
-                                                       {"Quality (Attribute Modifiers)", {misc_filter, misc_filter_quality}},
-                                                       {"Evasion Rating", {armour_filter, armour_filter_ev}},
-                                                       {"Energy Shield", {armour_filter, armour_filter_es}},
-                                                       {"Armour", {armour_filter, armour_filter_ar}},
-                                                       {"Chance to Block", {armour_filter, armour_filter_block}},
-                                                       {"Requirements", {special_filter}},
-                                                       {"Level", {special_filter}},
-                                                       {"req_level", {req_filter, req_filter_lvl}},
-                                                       {"gem_level", {misc_filter, misc_filter_gem_level}},
-                                                       {"Str", {req_filter, req_filter_str}},
-                                                       {"Dex", {req_filter, req_filter_dex}},
-                                                       {"Int", {req_filter, req_filter_int}},
-                                                       {"Sockets", {socket_filter}},
-                                                       {"Item Level", {misc_filter, misc_filter_ilvl}},
-                                                       {"Physical Damage", {weapon_filter, weapon_filter_pdps}},
-                                                       {"Critical Strike Chance", {weapon_filter, weapon_filter_crit}},
-                                                       {"Attacks per Second", {weapon_filter, weapon_filter_aps}},
-                                                       {"Elemental Damage", {weapon_filter, weapon_filter_edps}},
-                                                       {"Experience", {misc_filter, misc_filter_gem_level_progress}},
-                                                       {"Map Tier", {misc_filter, misc_filter_map_tier}}};
-
-    json                                                             c_baseCat;
-    json                                                             c_pseudoRules;
-    json                                                             c_enchantRules;
-    std::unordered_set<std::string>                                  c_weaponLocals;
-    std::unordered_set<std::string>                                  c_armourLocals;
-    std::unordered_map<std::string, std::unordered_set<std::string>> c_discriminators;
-    json                                                             c_currencyMap;
-    std::unordered_set<std::string>                                  c_currencyCodes;
-    std::unordered_set<std::string>                                  c_excludes;
-    std::unordered_map<std::string, mod_generation_type>             c_mods;
-
-    std::map<std::string, json> c_baseMap;
-
-    QString m_section;
-
-    json                                       m_leagues;
-    std::unordered_multimap<std::string, json> m_stats_by_text;
-    std::unordered_map<std::string, json>      m_stats_by_id;
-    std::unordered_multimap<std::string, json> m_uniques;
+    static constexpr auto c_propMap = perfect::make<prop_entry>({{"Quality", {misc_filter, misc_filter_quality}},
+                                                                 {"Quality (Elemental Damage)", {misc_filter, misc_filter_quality}},
+                                                                 {"Quality (Caster Modifiers)", {misc_filter, misc_filter_quality}},
+                                                                 {"Quality (Attack Modifiers)", {misc_filter, misc_filter_quality}},
+                                                                 {"Quality (Defence Modifiers)", {misc_filter, misc_filter_quality}},
+                                                                 {"Quality (Life and Mana Modifiers)", {misc_filter, misc_filter_quality}},
+                                                                 {"Quality (Resistance Modifiers)", {misc_filter, misc_filter_quality}},
+                                                                 {"Quality (Attribute Modifiers)", {misc_filter, misc_filter_quality}},
+                                                                 {"Evasion Rating", {armour_filter, armour_filter_ev}},
+                                                                 {"Energy Shield", {armour_filter, armour_filter_es}},
+                                                                 {"Armour", {armour_filter, armour_filter_ar}},
+                                                                 {"Chance to Block", {armour_filter, armour_filter_block}},
+                                                                 {"Requirements", {special_filter, special_filter_requirements}},
+                                                                 {"Level", {special_filter, special_filter_level}},
+                                                                 {"req_level", {req_filter, req_filter_lvl}},
+                                                                 {"gem_level", {misc_filter, misc_filter_gem_level}},
+                                                                 {"Str", {req_filter, req_filter_str}},
+                                                                 {"Dex", {req_filter, req_filter_dex}},
+                                                                 {"Int", {req_filter, req_filter_int}},
+                                                                 {"Sockets", {socket_filter, 0}},
+                                                                 {"Item Level", {misc_filter, misc_filter_ilvl}},
+                                                                 {"Physical Damage", {weapon_filter, weapon_filter_pdps}},
+                                                                 {"Critical Strike Chance", {weapon_filter, weapon_filter_crit}},
+                                                                 {"Attacks per Second", {weapon_filter, weapon_filter_aps}},
+                                                                 {"Elemental Damage", {weapon_filter, weapon_filter_edps}},
+                                                                 {"Experience", {misc_filter, misc_filter_gem_level_progress}},
+                                                                 {"Map Tier", {misc_filter, misc_filter_map_tier}}});
+
+    // Swapped RCU style, readers pin a generation by copying the pointer
+    std::atomic<std::shared_ptr<const Dataset>> m_data;
+
+    struct LoadState;
+    struct Validators;
+
+    // Logs how long every dataset of the first load took and where it came from
+    void reportStartup(const LoadState& state) const;
+
+    std::unique_ptr<LoadState>  m_load;
+    std::unique_ptr<Validators> m_validators; // of the documents the current generation was built from
+    QFuture<void>               m_snapshotWrite; // saving the last load, see handleLoadFinished
+    QString                     m_loadError;
+    QTimer                      m_refreshTimer;
 
     const std::string m_mapdisc = "warfortheatlas"; // default map discriminator
 
+    mutable ParseCache    m_parseCache;
+    mutable StatMissCache m_statMisses;
+
     QNetworkAccessManager* m_manager;
 };
\ No newline at end of file
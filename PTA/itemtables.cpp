@@ -0,0 +1,453 @@
+#include "itemtables.h"
+
+#include <algorithm>
+
+StringPool::ref StringPool::intern(std::string_view s)
+{
+    auto it = m_interned.find(std::string(s));
+    if (it != m_interned.end())
+    {
+        return {it->second, static_cast<uint32_t>(s.size())};
+    }
+
+    std::vector<char>& pool = m_pool.owned();
+
+    uint32_t offset = static_cast<uint32_t>(pool.size());
+    pool.insert(pool.end(), s.begin(), s.end());
+    m_interned.insert({std::string(s), offset});
+
+    return {offset, static_cast<uint32_t>(s.size())};
+}
+
+void StringPool::clear()
+{
+    m_pool.clear();
+    m_interned.clear();
+}
+
+BaseTable::index_t BaseTable::add(std::string_view name, std::string_view category, uint32_t implicits)
+{
+    index_t idx = static_cast<index_t>(m_name.size());
+
+    m_name.push_back(m_strings.intern(name));
+    m_implicits.push_back(implicits);
+
+    auto ci = std::find(m_categoryNames.begin(), m_categoryNames.end(), category);
+    if (ci == m_categoryNames.end())
+    {
+        ci = m_categoryNames.insert(m_categoryNames.end(), std::string(category));
+    }
+
+    m_category.push_back(static_cast<uint8_t>(std::distance(m_categoryNames.begin(), ci)));
+
+    return idx;
+}
+
+void BaseTable::seal()
+{
+    m_strings.seal();
+    m_byName.reserve(size());
+
+    // Same as the map this replaces, the first base of a name wins
+    for (index_t i = 0; i < size(); i++)
+    {
+        m_byName.insert(ptadb::hash(name(i)), i, [&](uint32_t e) { return name(e) == name(i); });
+    }
+}
+
+void BaseTable::clear()
+{
+    m_strings.clear();
+    m_name.clear();
+    m_category.clear();
+    m_implicits.clear();
+    m_categoryNames.assign(category_names.begin(), category_names.end());
+    m_byName.clear();
+}
+
+void BaseTable::save(ptadb::SectionWriter& w) const
+{
+    m_strings.save(w);
+    w.array(m_name);
+    w.array(m_category);
+    w.array(m_implicits);
+    w.array(m_byName.slots());
+
+    w.u32(static_cast<uint32_t>(m_categoryNames.size()));
+
+    for (const auto& c : m_categoryNames)
+    {
+        w.str(c);
+    }
+}
+
+bool BaseTable::restore(ptadb::SectionReader& r)
+{
+    clear();
+
+    ptadb::array<uint32_t> byName;
+    uint32_t               categories = 0;
+
+    bool ok = m_strings.restore(r) && r.array(m_name) && r.array(m_category) && r.array(m_implicits) && r.array(byName) && r.u32(categories);
+
+    m_categoryNames.clear();
+
+    for (std::string_view c; ok && m_categoryNames.size() < categories && r.str(c);)
+    {
+        m_categoryNames.emplace_back(c);
+    }
+
+    ok = ok && r.valid() && m_categoryNames.size() == categories && m_byName.restore(byName) && m_category.size() == size() && m_implicits.size() == size();
+
+    if (!ok)
+    {
+        clear();
+    }
+
+    return ok;
+}
+
+BaseTable::index_t BaseTable::find(std::string_view name) const
+{
+    return m_byName.find(ptadb::hash(name), [&](uint32_t e) { return this->name(e) == name; });
+}
+
+UniqueTable::index_t UniqueTable::add(std::string_view name, std::string_view type, std::string_view disc, uint8_t fields)
+{
+    index_t idx = static_cast<index_t>(m_fields.size());
+
+    m_name.push_back(m_strings.intern(name));
+    m_type.push_back(m_strings.intern(type));
+    m_disc.push_back(m_strings.intern(disc));
+    m_fields.push_back(fields);
+
+    return idx;
+}
+
+void UniqueTable::seal()
+{
+    m_strings.seal();
+
+    m_byKey.reserve(size());
+    m_byKeyType.reserve(size());
+    m_byEntry.reserve(size());
+
+    // Earlier entries win, like the first match of a scan in insertion order
+    for (index_t i = 0; i < size(); i++)
+    {
+        m_byKey.insert(ptadb::hash(key(i)), i, [&](uint32_t e) { return key(e) == key(i); });
+        m_byKeyType.insert(hash(key(i), type(i)), i, [&](uint32_t e) { return key(e) == key(i) && type(e) == type(i); });
+
+        if (hasDisc(i))
+        {
+            m_byEntry.insert(hash(key(i), type(i), disc(i)), i, [&](uint32_t e) { return key(e) == key(i) && type(e) == type(i) && disc(e) == disc(i); });
+        }
+    }
+}
+
+void UniqueTable::clear()
+{
+    m_strings.clear();
+    m_name.clear();
+    m_type.clear();
+    m_disc.clear();
+    m_fields.clear();
+    m_byKey.clear();
+    m_byKeyType.clear();
+    m_byEntry.clear();
+}
+
+void UniqueTable::save(ptadb::SectionWriter& w) const
+{
+    m_strings.save(w);
+    w.array(m_name);
+    w.array(m_type);
+    w.array(m_disc);
+    w.array(m_fields);
+    w.array(m_byKey.slots());
+    w.array(m_byKeyType.slots());
+    w.array(m_byEntry.slots());
+}
+
+bool UniqueTable::restore(ptadb::SectionReader& r)
+{
+    clear();
+
+    ptadb::array<uint32_t> byKey, byKeyType, byEntry;
+
+    bool ok = m_strings.restore(r) && r.array(m_name) && r.array(m_type) && r.array(m_disc) && r.array(m_fields) && r.array(byKey) && r.array(byKeyType) &&
+              r.array(byEntry) && m_byKey.restore(byKey) && m_byKeyType.restore(byKeyType) && m_byEntry.restore(byEntry) && m_name.size() == size() &&
+              m_type.size() == size() && m_disc.size() == size();
+
+    if (!ok)
+    {
+        clear();
+    }
+
+    return ok;
+}
+
+bool UniqueTable::contains(std::string_view key) const
+{
+    return (m_byKey.find(ptadb::hash(key), [&](uint32_t e) { return this->key(e) == key; }) != npos);
+}
+
+UniqueTable::index_t UniqueTable::find(std::string_view key, std::string_view type) const
+{
+    return m_byKeyType.find(hash(key, type), [&](uint32_t e) { return this->key(e) == key && this->type(e) == type; });
+}
+
+UniqueTable::index_t UniqueTable::find(std::string_view key, std::string_view type, std::string_view disc) const
+{
+    return m_byEntry.find(hash(key, type, disc), [&](uint32_t e) { return this->key(e) == key && this->type(e) == type && this->disc(e) == disc; });
+}
+
+AffixTable::index_t AffixTable::add(std::string_view name, mod_generation_type type)
+{
+    if (!m_added.insert(std::string(name)).second)
+    {
+        return npos;
+    }
+
+    index_t idx = static_cast<index_t>(m_name.size());
+
+    m_name.push_back(m_strings.intern(name));
+    m_type.push_back(static_cast<uint8_t>(type));
+
+    return idx;
+}
+
+void AffixTable::seal()
+{
+    m_strings.seal();
+    m_added.clear();
+
+    m_byName.reserve(size());
+
+    // Names were only added once
+    for (index_t i = 0; i < size(); i++)
+    {
+        m_byName.insert(ptadb::hash(name(i)), i, [](uint32_t) { return false; });
+    }
+
+    std::vector<std::string> prefixes;
+    std::vector<std::string> suffixes;
+
+    for (index_t i = 0; i < size(); i++)
+    {
+        std::string_view n = name(i);
+
+        if (type(i) == mod_generation_type::mod_prefix)
+        {
+            prefixes.emplace_back(n);
+        }
+        else if (type(i) == mod_generation_type::mod_suffix)
+        {
+            // Suffixes are matched from the end of the item name
+            suffixes.emplace_back(n.rbegin(), n.rend());
+        }
+    }
+
+    auto text = [](const std::string& k) -> std::string_view { return k; };
+    auto mark = [](uint32_t& terminal, const std::string&) { terminal = 1; };
+
+    std::sort(prefixes.begin(), prefixes.end());
+    std::sort(suffixes.begin(), suffixes.end());
+
+    m_prefixes.compile(prefixes, text, mark);
+    m_suffixes.compile(suffixes, text, mark);
+}
+
+void AffixTable::clear()
+{
+    m_strings.clear();
+    m_name.clear();
+    m_type.clear();
+    m_prefixes.clear();
+    m_suffixes.clear();
+    m_byName.clear();
+    m_added.clear();
+}
+
+void AffixTable::save(ptadb::SectionWriter& w) const
+{
+    m_strings.save(w);
+    w.array(m_name);
+    w.array(m_type);
+    w.array(m_byName.slots());
+
+    m_prefixes.save(w);
+    m_suffixes.save(w);
+}
+
+bool AffixTable::restore(ptadb::SectionReader& r)
+{
+    clear();
+
+    ptadb::array<uint32_t> byName;
+
+    bool ok = m_strings.restore(r) && r.array(m_name) && r.array(m_type) && r.array(byName) && m_prefixes.restore(r) && m_suffixes.restore(r) &&
+              m_byName.restore(byName) && m_type.size() == size();
+
+    if (!ok)
+    {
+        clear();
+    }
+
+    return ok;
+}
+
+AffixTable::index_t AffixTable::find(std::string_view name) const
+{
+    return m_byName.find(ptadb::hash(name), [&](uint32_t e) { return this->name(e) == name; });
+}
+
+AffixTable::Split AffixTable::split(std::string_view name, const BaseTable* bases) const
+{
+    candidates pre, suf;
+
+    size_t np = affixLengths(m_prefixes, name, false, pre);
+    size_t ns = affixLengths(m_suffixes, name, true, suf);
+
+    Split fallback = {std::string_view(), name, std::string_view()};
+    bool  cut      = false;
+
+    // Longest affixes first
+    for (size_t i = np; i-- > 0;)
+    {
+        for (size_t j = ns; j-- > 0;)
+        {
+            // Affixes are set off from the base by a space
+            size_t begin = (pre[i] ? pre[i] + 1 : 0);
+            size_t end   = (suf[j] ? name.size() - suf[j] - 1 : name.size());
+
+            if (begin >= end)
+            {
+                continue;
+            }
+
+            Split s = {name.substr(0, pre[i]), name.substr(begin, end - begin), name.substr(name.size() - suf[j])};
+
+            if (bases && bases->find(s.base) != BaseTable::npos)
+            {
+                return s;
+            }
+
+            if (!cut)
+            {
+                fallback = s;
+                cut      = true;
+            }
+        }
+    }
+
+    return fallback;
+}
+
+size_t AffixTable::affixLengths(const trie& t, std::string_view name, bool backwards, candidates& out)
+{
+    size_t n = 0;
+
+    out[n++] = 0;
+
+    if (t.empty())
+    {
+        return n;
+    }
+
+    uint32_t node = 0;
+
+    // An affix never makes up the whole name
+    for (size_t depth = 0; depth + 1 < name.size(); depth++)
+    {
+        char c = (backwards ? name[name.size() - 1 - depth] : name[depth]);
+
+        node = t.child(node, c);
+
+        if (node == npos)
+        {
+            break;
+        }
+
+        char next = (backwards ? name[name.size() - 2 - depth] : name[depth + 1]);
+
+        if (t.value(node) && next == ' ')
+        {
+            // Keep the longest ones if more than fit, dropping the shortest after the 0
+            if (n == out.size())
+            {
+                std::copy(out.begin() + 2, out.end(), out.begin() + 1);
+                n--;
+            }
+
+            out[n++] = depth + 1;
+        }
+    }
+
+    return n;
+}
+
+void CurrencyTable::add(std::string_view name, std::string_view code)
+{
+    m_name.push_back(m_strings.intern(name));
+    m_code.push_back(m_strings.intern(code));
+}
+
+void CurrencyTable::seal()
+{
+    m_strings.seal();
+
+    m_byName.reserve(size());
+    m_byCode.reserve(size());
+
+    for (index_t i = 0; i < size(); i++)
+    {
+        m_byName.insert(ptadb::hash(name(i)), i, [&](uint32_t e) { return name(e) == name(i); });
+        m_byCode.insert(ptadb::hash(code(i)), i, [&](uint32_t e) { return code(e) == code(i); });
+    }
+}
+
+void CurrencyTable::clear()
+{
+    m_strings.clear();
+    m_name.clear();
+    m_code.clear();
+    m_byName.clear();
+    m_byCode.clear();
+}
+
+void CurrencyTable::save(ptadb::SectionWriter& w) const
+{
+    m_strings.save(w);
+    w.array(m_name);
+    w.array(m_code);
+    w.array(m_byName.slots());
+    w.array(m_byCode.slots());
+}
+
+bool CurrencyTable::restore(ptadb::SectionReader& r)
+{
+    clear();
+
+    ptadb::array<uint32_t> byName, byCode;
+
+    bool ok = m_strings.restore(r) && r.array(m_name) && r.array(m_code) && r.array(byName) && r.array(byCode) && m_byName.restore(byName) &&
+              m_byCode.restore(byCode) && m_code.size() == size();
+
+    if (!ok)
+    {
+        clear();
+    }
+
+    return ok;
+}
+
+CurrencyTable::index_t CurrencyTable::find(std::string_view name) const
+{
+    return m_byName.find(ptadb::hash(name), [&](uint32_t e) { return this->name(e) == name; });
+}
+
+bool CurrencyTable::containsCode(std::string_view code) const
+{
+    return (m_byCode.find(ptadb::hash(code), [&](uint32_t e) { return this->code(e) == code; }) != npos);
+}
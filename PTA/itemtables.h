@@ -0,0 +1,313 @@
+#pragma once
+
+#include "bytetrie.h"
+#include "perfecthash.h"
+#include "ptadb.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Trade item categories. Bases resolve to the ones up to cat_wand, the rest
+// are set by the item parser. Categories added to base_categories.json later
+// are interned after item_category_known.
+enum item_category_e : uint8_t
+{
+    cat_amulet = 0,
+    cat_belt,
+    cat_ring,
+    cat_boots,
+    cat_chest,
+    cat_gloves,
+    cat_helmet,
+    cat_quiver,
+    cat_shield,
+    cat_currency,
+    cat_flask,
+    cat_active_gem,
+    cat_support_gem,
+    cat_jewel,
+    cat_abyss_jewel,
+    cat_bow,
+    cat_claw,
+    cat_dagger,
+    cat_one_axe,
+    cat_one_mace,
+    cat_one_sword,
+    cat_sceptre,
+    cat_staff,
+    cat_two_axe,
+    cat_two_mace,
+    cat_two_sword,
+    cat_wand,
+    cat_gem,
+    cat_card,
+    cat_map,
+    cat_prophecy,
+    item_category_known,
+    cat_none = UINT8_MAX
+};
+
+enum class mod_generation_type : uint8_t
+{
+    mod_prefix = 0,
+    mod_suffix,
+    mod_unknown
+};
+
+// Append-only pool of interned strings shared by the item tables
+class StringPool
+{
+public:
+    struct ref
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    ref              intern(std::string_view s);
+    std::string_view view(ref r) const { return std::string_view(m_pool.data() + r.offset, r.length); }
+
+    // Drops the build time intern table, views stay valid
+    void seal() { m_interned.clear(); }
+    void clear();
+
+    void save(ptadb::SectionWriter& w) const { w.array(m_pool); }
+    bool restore(ptadb::SectionReader& r) { return r.array(m_pool); }
+
+private:
+    ptadb::array<char>                        m_pool;
+    std::unordered_map<std::string, uint32_t> m_interned;
+};
+
+// Flat table of the RePoE base types, addressed by a dense uint32_t index
+class BaseTable
+{
+public:
+    using index_t = uint32_t;
+
+    static constexpr index_t npos = UINT32_MAX;
+
+    static constexpr std::array<const char*, item_category_known> category_names = {"accessory.amulet", "accessory.belt", "accessory.ring", "armour.boots",
+                                                                                    "armour.chest", "armour.gloves", "armour.helmet", "armour.quiver",
+                                                                                    "armour.shield", "currency", "flask", "gem.activegem", "gem.supportgem",
+                                                                                    "jewel", "jewel.abyss", "weapon.bow", "weapon.claw", "weapon.dagger",
+                                                                                    "weapon.oneaxe", "weapon.onemace", "weapon.onesword", "weapon.sceptre",
+                                                                                    "weapon.staff", "weapon.twoaxe", "weapon.twomace", "weapon.twosword",
+                                                                                    "weapon.wand", "gem", "card", "map", "prophecy"};
+
+    // Known category of a trade category name
+    static constexpr auto category_index = perfect::names<item_category_e>(category_names);
+
+    // Adds a base. find() is only available after seal()
+    index_t add(std::string_view name, std::string_view category, uint32_t implicits);
+
+    void seal();
+    void clear();
+
+    void save(ptadb::SectionWriter& w) const;
+    bool restore(ptadb::SectionReader& r);
+
+    size_t size() const { return m_name.size(); }
+    bool   empty() const { return m_name.empty(); }
+
+    std::string_view name(index_t i) const { return m_strings.view(m_name[i]); }
+    item_category_e  category(index_t i) const { return static_cast<item_category_e>(m_category[i]); }
+    std::string_view categoryName(index_t i) const { return m_categoryNames[m_category[i]]; }
+    uint32_t         implicits(index_t i) const { return m_implicits[i]; }
+
+    index_t find(std::string_view name) const;
+
+private:
+    StringPool m_strings;
+
+    ptadb::array<StringPool::ref> m_name;
+    ptadb::array<uint8_t>         m_category;
+    ptadb::array<uint32_t>        m_implicits;
+
+    std::vector<std::string> m_categoryNames = {category_names.begin(), category_names.end()};
+
+    ptadb::hash_index m_byName;
+};
+
+// Flat table of the trade API unique items (and the other named entries
+// of items.json such as prophecies).
+//
+// Entries are keyed like the trade API searches them, by name if they have
+// one and by type otherwise. Every (key, type, discriminator) combination
+// resolves to an entry with a single hash probe.
+class UniqueTable
+{
+public:
+    using index_t = uint32_t;
+
+    static constexpr index_t npos = UINT32_MAX;
+
+    enum field_e : uint8_t
+    {
+        field_name = 1,
+        field_type = 2,
+        field_disc = 4
+    };
+
+    // Adds an entry, fields says which of name, type and disc it has.
+    // The lookups are only available after seal()
+    index_t add(std::string_view name, std::string_view type, std::string_view disc, uint8_t fields);
+
+    void seal();
+    void clear();
+
+    void save(ptadb::SectionWriter& w) const;
+    bool restore(ptadb::SectionReader& r);
+
+    size_t size() const { return m_fields.size(); }
+    bool   empty() const { return m_fields.empty(); }
+
+    std::string_view key(index_t i) const { return (hasName(i) ? name(i) : type(i)); }
+    std::string_view name(index_t i) const { return m_strings.view(m_name[i]); }
+    std::string_view type(index_t i) const { return m_strings.view(m_type[i]); }
+    std::string_view disc(index_t i) const { return m_strings.view(m_disc[i]); }
+    uint8_t          fields(index_t i) const { return m_fields[i]; }
+    bool             hasName(index_t i) const { return (m_fields[i] & field_name); }
+    bool             hasDisc(index_t i) const { return (m_fields[i] & field_disc); }
+
+    // Whether anything is searched for by this name or type
+    bool contains(std::string_view key) const;
+
+    // First entry with this key and type, whatever its discriminator
+    index_t find(std::string_view key, std::string_view type) const;
+
+    // Entry with this key, type and discriminator
+    index_t find(std::string_view key, std::string_view type, std::string_view disc) const;
+
+private:
+    static uint64_t hash(std::string_view key, std::string_view type) { return ptadb::hash(type, ptadb::hash(key)); }
+    static uint64_t hash(std::string_view key, std::string_view type, std::string_view disc) { return ptadb::hash(disc, hash(key, type)); }
+
+private:
+    StringPool m_strings;
+
+    ptadb::array<StringPool::ref> m_name;
+    ptadb::array<StringPool::ref> m_type;
+    ptadb::array<StringPool::ref> m_disc;
+    ptadb::array<uint8_t>         m_fields;
+
+    // Lookups, comparing against the strings in m_strings
+    ptadb::hash_index m_byKey;     // key
+    ptadb::hash_index m_byKeyType; // key and type, whatever the discriminator
+    ptadb::hash_index m_byEntry;   // key, type and discriminator of the entries that have one
+};
+
+// Flat table of the RePoE magic affix names, addressed by a dense uint32_t index.
+//
+// seal() compiles the prefix names into a trie read from the start of an item
+// name and the suffix names into one read backwards from its end, so a magic
+// item name splits into prefix, base and suffix with one walk from each end,
+// see split().
+class AffixTable
+{
+public:
+    using index_t = uint32_t;
+
+    static constexpr index_t npos = UINT32_MAX;
+
+    // A magic item name cut into its parts, prefix and suffix are empty if it has none
+    struct Split
+    {
+        std::string_view prefix;
+        std::string_view base;
+        std::string_view suffix;
+    };
+
+    // Adds an affix, npos if the name is already in. split() is only available after seal()
+    index_t add(std::string_view name, mod_generation_type type);
+
+    void seal();
+    void clear();
+
+    void save(ptadb::SectionWriter& w) const;
+    bool restore(ptadb::SectionReader& r);
+
+    size_t size() const { return m_name.size(); }
+    bool   empty() const { return m_name.empty(); }
+
+    std::string_view    name(index_t i) const { return m_strings.view(m_name[i]); }
+    mod_generation_type type(index_t i) const { return static_cast<mod_generation_type>(m_type[i]); }
+
+    index_t find(std::string_view name) const;
+
+    // Splits a magic item name at the longest prefix and suffix that leave a base known
+    // to bases in between. If no such base exists, or bases is null, the longest affixes
+    // that leave anything in between are cut off.
+    Split split(std::string_view name, const BaseTable* bases) const;
+
+private:
+    static constexpr size_t max_candidates = 8;
+
+    // Trie of affix names, marking the nodes an affix name ends at with 1. The mark is
+    // as wide as the rest of a node, which leaves the nodes no padding
+    using trie = byte_trie<uint32_t>;
+
+    using candidates = std::array<size_t, max_candidates>;
+
+    // Lengths of the affixes name starts with (or ends with, walking backwards) that are
+    // set off from the rest of it by a space, shortest first after a leading 0 for none
+    static size_t affixLengths(const trie& t, std::string_view name, bool backwards, candidates& out);
+
+private:
+    StringPool m_strings;
+
+    ptadb::array<StringPool::ref> m_name;
+    ptadb::array<uint8_t>         m_type;
+
+    trie m_prefixes;
+    trie m_suffixes; // names reversed
+
+    ptadb::hash_index m_byName;
+
+    // Build time only
+    std::unordered_set<std::string> m_added;
+};
+
+// The currency codes of the bulk exchange and the item names they stand for
+class CurrencyTable
+{
+public:
+    using index_t = uint32_t;
+
+    static constexpr index_t npos = UINT32_MAX;
+
+    // Adds a currency item. The lookups are only available after seal()
+    void add(std::string_view name, std::string_view code);
+
+    void seal();
+    void clear();
+
+    void save(ptadb::SectionWriter& w) const;
+    bool restore(ptadb::SectionReader& r);
+
+    size_t size() const { return m_name.size(); }
+    bool   empty() const { return m_name.empty(); }
+
+    std::string_view name(index_t i) const { return m_strings.view(m_name[i]); }
+    std::string_view code(index_t i) const { return m_strings.view(m_code[i]); }
+
+    // Currency item with this name
+    index_t find(std::string_view name) const;
+
+    // Whether any currency item has this code
+    bool containsCode(std::string_view code) const;
+
+private:
+    StringPool m_strings;
+
+    ptadb::array<StringPool::ref> m_name;
+    ptadb::array<StringPool::ref> m_code;
+
+    ptadb::hash_index m_byName;
+    ptadb::hash_index m_byCode; // first item of every code
+};
@@ -7,6 +7,7 @@
 #include <QSettings>
 #include <QStandardPaths>
 #include <QTextStream>
+#include <QThread>
 
 #include <mutex>
 
@@ -84,7 +85,15 @@ void msg_handler(QtMsgType type, const QMessageLogContext& context, const QStrin
 
         if (s_logEdit)
         {
-            s_logEdit->appendPlainText(output);
+            if (QThread::currentThread() == s_logEdit->thread())
+            {
+                s_logEdit->appendPlainText(output);
+            }
+            else
+            {
+                // Widgets may only be touched from the GUI thread
+                QMetaObject::invokeMethod(s_logEdit, "appendPlainText", Qt::QueuedConnection, Q_ARG(QString, output));
+            }
         }
 
         if (logFile && !s_logFile)
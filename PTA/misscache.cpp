@@ -0,0 +1,97 @@
+#include "misscache.h"
+#include "ptadb.h"
+
+#include <algorithm>
+
+StatMissCache::StatMissCache(size_t capacity) : m_capacity(std::max<size_t>(capacity / shard_count, 1)) {}
+
+uint64_t StatMissCache::lineKey(std::string_view line, uint32_t variant)
+{
+    // Hashed after the line, a variant folded into the seed only flips low bits
+    // that the first byte of another line can flip right back
+    uint64_t h = ptadb::hash(line.data(), line.size());
+
+    return ptadb::hash(reinterpret_cast<const char*>(&variant), sizeof(variant), h);
+}
+
+bool StatMissCache::contains(uint64_t data, uint64_t line)
+{
+    shard& s = shardOf(line);
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    if (data != s.data)
+    {
+        s.reset(data);
+    }
+
+    if (s.lines.contains(line))
+    {
+        s.counted.hits++;
+        return true;
+    }
+
+    s.counted.misses++;
+    return false;
+}
+
+void StatMissCache::insert(uint64_t data, uint64_t line)
+{
+    shard& s = shardOf(line);
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    if (data != s.data)
+    {
+        s.reset(data);
+    }
+
+    if (!s.lines.insert(line).second)
+    {
+        return;
+    }
+
+    if (s.order.size() < m_capacity)
+    {
+        s.order.push_back(line);
+        return;
+    }
+
+    // Full, replace the oldest line
+    s.lines.erase(s.order[s.next]);
+    s.order[s.next] = line;
+    s.next          = (s.next + 1) % m_capacity;
+}
+
+StatMissCache::counts StatMissCache::counters() const
+{
+    counts total;
+
+    for (const auto& s : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        total.hits += s.counted.hits;
+        total.misses += s.counted.misses;
+    }
+
+    return total;
+}
+
+void StatMissCache::clear()
+{
+    for (auto& s : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        s.reset(s.data);
+    }
+}
+
+void StatMissCache::shard::reset(uint64_t key)
+{
+    data = key;
+    lines.clear();
+    order.clear();
+    next = 0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// Bounded set of stat lines known to resolve to no stat, like flavour text,
+// lore and veiled mods, so the parser can drop them without another lookup.
+//
+// The set only holds for the data key it was filled under, see
+// ItemAPI::ParseContext. Once full, the oldest lines make room for new ones.
+//
+// Lines are spread over shards by their key, each with its own lock, ring and
+// data key, so parses running in parallel (see ItemAPI::parseBatch) rarely
+// wait on each other. The first lookup or insert in a shard under a different
+// data key empties that shard.
+class StatMissCache
+{
+public:
+    static constexpr size_t default_capacity = 4096;
+    static constexpr size_t shard_count      = 16;
+
+    struct counts
+    {
+        uint64_t hits   = 0; // lines skipped
+        uint64_t misses = 0; // lines that had to be looked up
+    };
+
+    // capacity is split evenly between the shards
+    explicit StatMissCache(size_t capacity = default_capacity);
+
+    // Key of a stat line. variant tells apart items the line may resolve
+    // differently for, e.g. through the weapon and armour local rules
+    static uint64_t lineKey(std::string_view line, uint32_t variant);
+
+    bool contains(uint64_t data, uint64_t line);
+    void insert(uint64_t data, uint64_t line);
+
+    counts counters() const;
+    void   clear();
+
+private:
+    // Kept on cache lines of their own so shards do not contend through them either
+    struct alignas(64) shard
+    {
+        mutable std::mutex mutex;
+
+        uint64_t                     data = 0;
+        std::unordered_set<uint64_t> lines;
+        std::vector<uint64_t>        order; // ring of the lines in insertion order
+        size_t                       next = 0;
+        counts                       counted;
+
+        void reset(uint64_t key);
+    };
+
+    // Keys are already hashes, their top bits pick the shard
+    shard& shardOf(uint64_t line) { return m_shards[(line >> 58) % shard_count]; }
+
+private:
+    size_t                         m_capacity; // per shard
+    std::array<shard, shard_count> m_shards;
+};
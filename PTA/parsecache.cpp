@@ -0,0 +1,220 @@
+#include "parsecache.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+
+uint64_t ParseCache::textHash(const QString& itemText)
+{
+    QStringList lines = itemText.split('\n');
+    QStringList kept;
+
+    for (const auto& line : lines)
+    {
+        QString l = line.trimmed();
+
+        if (l.isEmpty() || l.startsWith("Note:"))
+        {
+            continue;
+        }
+
+        kept << l;
+    }
+
+    // The note has its own section
+    while (!kept.isEmpty() && kept.last().startsWith("---"))
+    {
+        kept.removeLast();
+    }
+
+    QByteArray normalized = kept.join('\n').toUtf8();
+
+    return ptadb::hash(normalized.constData(), normalized.size());
+}
+
+bool ParseCache::find(uint64_t text, uint64_t data, const std::shared_ptr<const Dataset>& gen, Item& item)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(text);
+
+    if (it == m_index.end())
+    {
+        return false;
+    }
+
+    auto e = it->second;
+
+    if (e->data != data)
+    {
+        // Parsed against different tables. Persisted entries stay around in case
+        // this parse ran before the matching tables were loaded
+        if (e->pending.is_null())
+        {
+            erase(e);
+        }
+
+        return false;
+    }
+
+    if (!e->pending.is_null())
+    {
+        try
+        {
+            e->item = Item::fromJson(e->pending, gen);
+        } catch (const json::exception& ex)
+        {
+            // A field of the wrong type in the cache file, parse the item again instead
+            qWarning() << "Dropping unreadable parse cache entry:" << ex.what();
+            erase(e);
+            return false;
+        }
+
+        e->item.gen.reset();
+        e->pending = nullptr;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, e);
+
+    item     = e->item;
+    item.gen = gen;
+
+    return true;
+}
+
+void ParseCache::insert(uint64_t text, uint64_t data, const Item& item)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(text);
+
+    if (it != m_index.end())
+    {
+        erase(it->second);
+    }
+
+    m_entries.push_front({text, data, item, json()});
+    m_entries.front().item.gen.reset();
+
+    m_index[text] = m_entries.begin();
+
+    while (m_entries.size() > m_capacity)
+    {
+        erase(std::prev(m_entries.end()));
+    }
+}
+
+void ParseCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_entries.clear();
+    m_index.clear();
+}
+
+void ParseCache::erase(list_type::iterator it)
+{
+    m_index.erase(it->text);
+    m_entries.erase(it);
+}
+
+bool ParseCache::load(const QString& path)
+{
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QByteArray raw = file.readAll();
+
+    json doc = json::parse(raw.begin(), raw.end(), nullptr, false);
+
+    // The file is only ever written by save(), but a damaged one must not take the app down
+    if (doc.is_discarded() || !doc.is_object() || !doc.contains("data") || !doc["data"].is_number_unsigned() || !doc.contains("entries") ||
+        !doc["entries"].is_array())
+    {
+        qWarning() << "Ignoring unreadable parse cache" << path;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint64_t data    = doc["data"].get<uint64_t>();
+    size_t   skipped = 0;
+
+    // Stored most recently used first
+    for (const auto& e : doc["entries"])
+    {
+        if (m_entries.size() == m_capacity)
+        {
+            break;
+        }
+
+        if (!e.is_object() || !e.contains("text") || !e["text"].is_number_unsigned() || !e.contains("item") || !e["item"].is_object())
+        {
+            skipped++;
+            continue;
+        }
+
+        uint64_t text = e["text"].get<uint64_t>();
+
+        if (m_index.contains(text))
+        {
+            continue;
+        }
+
+        m_entries.push_back({text, data, Item(), e["item"]});
+        m_index[text] = std::prev(m_entries.end());
+    }
+
+    if (skipped)
+    {
+        qWarning() << "Skipped" << skipped << "unreadable entries of the parse cache" << path;
+    }
+
+    qDebug() << "Loaded" << m_entries.size() << "cached items from" << path;
+
+    return true;
+}
+
+bool ParseCache::save(const QString& path, uint64_t data, const std::shared_ptr<const Dataset>& gen) const
+{
+    json doc = {{"data", data}, {"entries", json::array()}};
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (const auto& e : m_entries)
+        {
+            // Stat indices only mean something to the tables they were parsed against
+            if (e.data != data)
+            {
+                continue;
+            }
+
+            if (!e.pending.is_null())
+            {
+                doc["entries"].push_back({{"text", e.text}, {"item", e.pending}});
+                continue;
+            }
+
+            Item item = e.item;
+            item.gen  = gen;
+
+            doc["entries"].push_back({{"text", e.text}, {"item", item.toJson()}});
+        }
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    std::string out = doc.dump();
+
+    QSaveFile sf(path);
+
+    return (sf.open(QIODevice::WriteOnly) && sf.write(out.data(), out.size()) == qint64(out.size()) && sf.commit());
+}
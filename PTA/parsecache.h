@@ -0,0 +1,58 @@
+#pragma once
+
+#include "pitem.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <QString>
+
+// Bounded LRU of parsed items, keyed by a hash of their normalized text.
+//
+// Every entry is tagged with the data key of the parse that produced it, which
+// identifies the dataset tables the parse read. An entry is only handed out
+// to a parse with the same data key, so anything cached against an older
+// dataset generation is dropped the first time it is looked up.
+class ParseCache
+{
+public:
+    static constexpr size_t default_capacity = 256;
+
+    explicit ParseCache(size_t capacity = default_capacity) : m_capacity(capacity) {}
+
+    // Hash of an item text without the parts that never affect parsing,
+    // i.e. the price note and surrounding whitespace
+    static uint64_t textHash(const QString& itemText);
+
+    // Copies the cached item into item and attaches gen to it
+    bool find(uint64_t text, uint64_t data, const std::shared_ptr<const Dataset>& gen, Item& item);
+    void insert(uint64_t text, uint64_t data, const Item& item);
+
+    void clear();
+
+    // Persisted entries are kept as JSON until a parse with the same data key asks for them
+    bool load(const QString& path);
+    bool save(const QString& path, uint64_t data, const std::shared_ptr<const Dataset>& gen) const;
+
+private:
+    struct entry
+    {
+        uint64_t text;
+        uint64_t data;
+        Item     item;    // without gen, so the cache never holds on to a generation
+        json     pending; // persisted item that has not been read back yet
+    };
+
+    using list_type = std::list<entry>;
+
+    void erase(list_type::iterator it);
+
+private:
+    mutable std::mutex m_mutex;
+
+    size_t                                            m_capacity;
+    list_type                                         m_entries; // most recently used first
+    std::unordered_map<uint64_t, list_type::iterator> m_index;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+// Compile time perfect hash tables for the fixed vocabularies of the item
+// parser, like property names and rarities.
+//
+// A table searches for a seed that sends every key to a slot of its own when
+// it is constructed, which happens at compile time for a constexpr table, so
+// a lookup is one hash and one compare. Keys and probes are UTF-8 string
+// views, hashed byte by byte.
+namespace perfect
+{
+    constexpr uint32_t hash(uint32_t seed, std::string_view key)
+    {
+        uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+
+        for (char c : key)
+        {
+            h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+
+        // FNV leaves the low bits poorly mixed
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+
+        return h;
+    }
+
+    template <typename T, size_t N>
+    class map
+    {
+    public:
+        using entry = std::pair<std::string_view, T>;
+
+        static_assert(N > 0 && N < UINT8_MAX, "slots hold 8-bit entry indices");
+
+        static constexpr size_t slot_count = std::bit_ceil(N * 4);
+
+        constexpr explicit map(const std::array<entry, N>& entries) : m_entries(entries)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                for (size_t j = i + 1; j < N; j++)
+                {
+                    if (m_entries[i].first == m_entries[j].first)
+                    {
+                        throw std::logic_error("duplicate key");
+                    }
+                }
+            }
+
+            while (!place())
+            {
+                m_seed++;
+            }
+        }
+
+        constexpr size_t size() const { return N; }
+
+        // Value of a key, nullptr for anything else
+        constexpr const T* find(std::string_view key) const
+        {
+            uint8_t e = m_slots[hash(m_seed, key) & (slot_count - 1)];
+
+            return (e != empty && m_entries[e].first == key ? &m_entries[e].second : nullptr);
+        }
+
+    private:
+        static constexpr uint8_t empty = UINT8_MAX;
+
+        constexpr bool place()
+        {
+            m_slots.fill(empty);
+
+            for (size_t i = 0; i < N; i++)
+            {
+                uint8_t& slot = m_slots[hash(m_seed, m_entries[i].first) & (slot_count - 1)];
+
+                if (slot != empty)
+                {
+                    return false;
+                }
+
+                slot = static_cast<uint8_t>(i);
+            }
+
+            return true;
+        }
+
+    private:
+        std::array<entry, N>            m_entries;
+        std::array<uint8_t, slot_count> m_slots = {};
+        uint32_t                        m_seed  = 0;
+    };
+
+    // Table of the given keys and values, e.g. make<int>({{"one", 1}, {"two", 2}})
+    template <typename T, size_t N>
+    constexpr map<T, N> make(const std::pair<std::string_view, T> (&entries)[N])
+    {
+        std::array<std::pair<std::string_view, T>, N> a = {};
+
+        for (size_t i = 0; i < N; i++)
+        {
+            a[i] = entries[i];
+        }
+
+        return map<T, N>(a);
+    }
+
+    // Table from every name of a list to its index in the list
+    template <typename T, size_t N>
+    constexpr map<T, N> names(const std::array<const char*, N>& list)
+    {
+        std::array<std::pair<std::string_view, T>, N> a = {};
+
+        for (size_t i = 0; i < N; i++)
+        {
+            a[i] = {list[i], static_cast<T>(i)};
+        }
+
+        return map<T, N>(a);
+    }
+}
@@ -1 +1,668 @@
 #include "pitem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    json rangeJson(const IntRange& r)
+    {
+        return {{p_min, r.min}, {p_max, r.max}};
+    }
+
+    IntRange readRange(const json& j)
+    {
+        return {j.value(p_min, 0), j.value(p_max, 0)};
+    }
+
+    json valuesJson(const ItemFilter& f)
+    {
+        json value = json::array();
+
+        for (size_t i = 0; i < f.count; i++)
+        {
+            if (f.isReal(i))
+            {
+                value.push_back(f.values[i]);
+            }
+            else
+            {
+                value.push_back(static_cast<int>(f.values[i]));
+            }
+        }
+
+        return value;
+    }
+
+    void readFilters(const json& j, const StatTable& stats, std::vector<ItemFilter>& out)
+    {
+        for (const auto& [id, e] : j.items())
+        {
+            ItemFilter f;
+
+            // The index the filter was listed with saves the lookup, unless the stat table changed since
+            StatTable::index_t stat = e.value(p_stat, StatTable::npos);
+
+            f.stat = (stat < stats.size() && stats.id(stat) == id ? stat : stats.find(id));
+
+            if (f.stat == StatTable::npos)
+            {
+                continue;
+            }
+
+            if (e.contains("value"))
+            {
+                for (const auto& v : e["value"])
+                {
+                    f.push(v.get<double>(), v.is_number_float());
+                }
+            }
+
+            f.enabled = e.value(p_enabled, false);
+
+            // Cleared inputs come back as null
+            if (e.contains(p_min) && e[p_min].is_number())
+            {
+                f.hasMin = true;
+                f.min    = e[p_min].get<double>();
+            }
+
+            if (e.contains(p_max) && e[p_max].is_number())
+            {
+                f.hasMax = true;
+                f.max    = e[p_max].get<double>();
+            }
+
+            out.push_back(f);
+        }
+    }
+}
+
+void ItemFilter::push(double value, bool isReal)
+{
+    if (count == max_values)
+    {
+        return;
+    }
+
+    values[count] = value;
+
+    if (isReal)
+    {
+        real |= (1u << count);
+    }
+
+    count++;
+}
+
+json ItemFilter::toJson(const StatTable& stats) const
+{
+    json entry = {{"id", std::string(stats.id(stat))}, {"text", std::string(stats.text(stat))}, {"type", std::string(stats.typeName(stat))}};
+
+    entry[p_stat]    = stat;
+    entry["value"]   = valuesJson(*this);
+    entry[p_enabled] = enabled;
+
+    if (hasMin)
+    {
+        entry[p_min] = min;
+    }
+
+    if (hasMax)
+    {
+        entry[p_max] = max;
+    }
+
+    return entry;
+}
+
+json ItemFilter::toQueryJson(const StatTable& stats) const
+{
+    json entry = {{"id", std::string(stats.id(stat))}, {"value", valuesJson(*this)}, {"disabled", !enabled}};
+
+    if (hasMin)
+    {
+        entry[p_min] = min;
+    }
+
+    if (hasMax)
+    {
+        entry[p_max] = max;
+    }
+
+    return entry;
+}
+
+std::string_view Item::categoryName() const
+{
+    if (category < item_category_known)
+    {
+        return BaseTable::category_names[category];
+    }
+
+    if (category != cat_none && gen && base != BaseTable::npos)
+    {
+        return gen->bases().categoryName(base);
+    }
+
+    return std::string_view();
+}
+
+ItemFilter* Item::filter(StatTable::index_t stat)
+{
+    auto it = std::find_if(filters.begin(), filters.end(), [=](const ItemFilter& f) { return f.stat == stat; });
+    return (it != filters.end() ? &*it : nullptr);
+}
+
+const ItemFilter* Item::filter(StatTable::index_t stat) const
+{
+    auto it = std::find_if(filters.begin(), filters.end(), [=](const ItemFilter& f) { return f.stat == stat; });
+    return (it != filters.end() ? &*it : nullptr);
+}
+
+ItemFilter* Item::pseudo(StatTable::index_t stat)
+{
+    auto it = std::find_if(pseudos.begin(), pseudos.end(), [=](const ItemFilter& f) { return f.stat == stat; });
+    return (it != pseudos.end() ? &*it : nullptr);
+}
+
+namespace
+{
+    // Pseudo totals of a batch of items as plain numbers, a row of slots per item
+    // and max_values values per slot. The count and float bits of every slot are
+    // kept beside the values, the ItemFilters are only made in emitPseudos
+    struct PseudoTotals
+    {
+        static constexpr size_t  width = ItemFilter::max_values;
+        static constexpr uint8_t unfed = UINT8_MAX; // count of a slot no filter fed yet
+
+        PseudoTotals(size_t items, size_t slots) : slots(slots), values(items * slots * width, 0.0), count(items * slots, unfed), real(items * slots, 0) {}
+
+        size_t               slots;
+        std::vector<double>  values;
+        std::vector<uint8_t> count;
+        std::vector<uint8_t> real;
+    };
+
+    // Adds the filters of one item to its row of totals. Every slot is worked on
+    // over all of its values, with the values past the count masked off
+    void accumulatePseudos(const PseudoTable& table, const std::vector<ItemFilter>& filters, PseudoTotals& totals, size_t row)
+    {
+        constexpr size_t width = PseudoTotals::width;
+
+        for (const auto& fil : filters)
+        {
+            auto [first, last] = table.terms(fil.stat);
+
+            for (auto t = first; t != last; t++)
+            {
+                size_t   s     = row * totals.slots + t->pseudo;
+                double*  sum   = totals.values.data() + s * width;
+                uint8_t& count = totals.count[s];
+
+                if (count == PseudoTotals::unfed)
+                {
+                    // The first stat sets the values, integers cut to whole numbers
+                    for (size_t i = 0; i < width; i++)
+                    {
+                        double v = fil.values[i] * t->factor;
+                        sum[i]   = (i < fil.count ? (fil.isReal(i) ? v : std::trunc(v)) : 0.0);
+                    }
+
+                    count          = fil.count;
+                    totals.real[s] = fil.real;
+                    continue;
+                }
+
+                if (!t->add)
+                {
+                    continue;
+                }
+
+                size_t n = std::min(fil.count, count);
+
+                for (size_t i = 0; i < width; i++)
+                {
+                    double v = fil.values[i] * t->factor;
+                    double r = (fil.isReal(i) ? sum[i] + v : std::trunc(sum[i]) + std::trunc(v));
+                    sum[i]   = (i < n ? r : sum[i]);
+                }
+            }
+        }
+    }
+
+    void emitPseudos(const PseudoTable& table, const PseudoTotals& totals, size_t row, std::vector<ItemFilter>& pseudos)
+    {
+        pseudos.clear();
+
+        for (size_t s = row * totals.slots, end = s + totals.slots; s < end; s++)
+        {
+            if (totals.count[s] == PseudoTotals::unfed)
+            {
+                continue;
+            }
+
+            ItemFilter& pse = pseudos.emplace_back();
+
+            pse.stat  = table.stat(static_cast<PseudoTable::slot_t>(s - row * totals.slots));
+            pse.count = totals.count[s];
+            pse.real  = totals.real[s];
+
+            std::copy_n(totals.values.data() + s * PseudoTotals::width, PseudoTotals::width, pse.values.begin());
+        }
+    }
+}
+
+void Item::computePseudos()
+{
+    if (!gen)
+    {
+        return;
+    }
+
+    const PseudoTable& table = gen->pseudos();
+
+    PseudoTotals totals(1, table.slots());
+
+    accumulatePseudos(table, filters, totals, 0);
+    emitPseudos(table, totals, 0, pseudos);
+}
+
+void Item::computePseudos(const std::vector<Item*>& items)
+{
+    if (items.empty() || !items.front()->gen)
+    {
+        return;
+    }
+
+    const PseudoTable& table = items.front()->gen->pseudos();
+
+    // One block of totals for the whole batch
+    PseudoTotals totals(items.size(), table.slots());
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        accumulatePseudos(table, items[i]->filters, totals, i);
+    }
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        emitPseudos(table, totals, i, items[i]->pseudos);
+    }
+}
+
+json Item::toJson() const
+{
+    json j = json::object();
+
+    j[p_origtext] = origtext;
+    j[p_rarity]   = rarityName();
+    j[p_type]     = type;
+
+    if (has(field_name))
+    {
+        j[p_name] = name;
+    }
+
+    if (category != cat_none)
+    {
+        j[p_category] = categoryName();
+    }
+
+    if (has(field_quality))
+    {
+        j[p_quality] = quality;
+    }
+
+    if (has(field_ilvl))
+    {
+        j[p_ilvl] = ilvl;
+    }
+
+    if (has(field_unidentified))
+    {
+        j[p_unidentified] = true;
+    }
+
+    if (has(field_corrupted))
+    {
+        j[p_corrupted] = true;
+    }
+
+    if (influences.any())
+    {
+        j[p_influences] = json::array();
+
+        for (size_t i = 0; i < influences_max; i++)
+        {
+            if (influences.test(i))
+            {
+                j[p_influences].push_back(influence_names[i]);
+            }
+        }
+    }
+
+    if (has(field_req_lvl))
+    {
+        j[p_reqlvl] = requirements.lvl;
+    }
+
+    if (has(field_req_str))
+    {
+        j[p_reqstr] = requirements.str;
+    }
+
+    if (has(field_req_dex))
+    {
+        j[p_reqdex] = requirements.dex;
+    }
+
+    if (has(field_req_int))
+    {
+        j[p_reqint] = requirements.intell;
+    }
+
+    if (has(field_weapon))
+    {
+        if (has(field_weapon_aps))
+        {
+            j[p_waps] = weapon.aps;
+        }
+
+        if (has(field_weapon_crit))
+        {
+            j[p_wcrit] = weapon.crit;
+        }
+
+        if (has(field_weapon_pdps))
+        {
+            j[p_wpdps] = rangeJson(weapon.pdps);
+        }
+
+        if (has(field_weapon_edps))
+        {
+            j[p_wedps] = rangeJson(weapon.edps);
+        }
+
+        j[p_weapon][p_enabled] = false;
+    }
+
+    if (has(field_armour))
+    {
+        if (has(field_armour_ar))
+        {
+            j[p_aar] = armour.ar;
+        }
+
+        if (has(field_armour_ev))
+        {
+            j[p_aev] = armour.ev;
+        }
+
+        if (has(field_armour_es))
+        {
+            j[p_aes] = armour.es;
+        }
+
+        if (has(field_armour_block))
+        {
+            j[p_ablock] = armour.block;
+        }
+
+        j[p_armour][p_enabled] = false;
+    }
+
+    if (has(field_sockets))
+    {
+        j[p_sockets] = {{"links", sockets.links},
+                        {"total", sockets.total},
+                        {"R", sockets.R},
+                        {"G", sockets.G},
+                        {"B", sockets.B},
+                        {"W", sockets.W},
+                        {"A", sockets.A}};
+    }
+
+    if (has(field_misc_disc))
+    {
+        j[p_mdisc] = misc.disc;
+    }
+
+    if (has(field_misc_synthesis))
+    {
+        j[p_msynth] = true;
+    }
+
+    if (has(field_misc_gem_level))
+    {
+        j[p_mglvl] = misc.gemLevel;
+    }
+
+    if (has(field_misc_gem_progress))
+    {
+        j[p_mgexp] = misc.gemProgress;
+    }
+
+    if (has(field_misc_map_tier))
+    {
+        j[p_mmtier] = misc.mapTier;
+    }
+
+    if (gen)
+    {
+        for (const auto& f : filters)
+        {
+            j[p_filters][std::string(gen->stats().id(f.stat))] = f.toJson(gen->stats());
+        }
+
+        for (const auto& f : pseudos)
+        {
+            j[p_pseudos][std::string(gen->stats().id(f.stat))] = f.toJson(gen->stats());
+        }
+    }
+
+    return j;
+}
+
+Item Item::fromJson(const json& j, std::shared_ptr<const Dataset> gen)
+{
+    Item item;
+
+    item.gen      = gen;
+    item.origtext = j.value(p_origtext, "");
+    item.type     = j.value(p_type, "");
+    item.rarity   = rarity_unknown;
+
+    if (auto r = rarity_index.find(j.value(p_rarity, "")))
+    {
+        item.rarity = std::min(*r, rarity_unknown);
+    }
+
+    if (j.contains(p_name))
+    {
+        item.name = j[p_name].get<std::string>();
+        item.set(field_name);
+    }
+
+    if (j.contains(p_category))
+    {
+        std::string cat   = j[p_category].get<std::string>();
+        auto        known = BaseTable::category_index.find(cat);
+
+        if (gen)
+        {
+            item.base = gen->bases().find(item.type);
+        }
+
+        if (known)
+        {
+            item.category = *known;
+        }
+        else if (item.base != BaseTable::npos && gen->bases().categoryName(item.base) == cat)
+        {
+            // Category the base table interned at load
+            item.category = gen->bases().category(item.base);
+        }
+    }
+
+    if (j.contains(p_quality))
+    {
+        item.quality = j[p_quality].get<int>();
+        item.set(field_quality);
+    }
+
+    if (j.contains(p_ilvl))
+    {
+        item.ilvl = j[p_ilvl].get<int>();
+        item.set(field_ilvl);
+    }
+
+    if (j.value(p_unidentified, false))
+    {
+        item.set(field_unidentified);
+    }
+
+    if (j.value(p_corrupted, false))
+    {
+        item.set(field_corrupted);
+    }
+
+    if (j.contains(p_influences))
+    {
+        for (const auto& i : j[p_influences])
+        {
+            if (auto idx = influence_index.find(i.get<std::string>()))
+            {
+                item.influences.set(*idx);
+            }
+        }
+    }
+
+    if (j.contains(p_reqlvl))
+    {
+        item.requirements.lvl = j[p_reqlvl].get<int>();
+        item.set(field_req_lvl);
+    }
+
+    if (j.contains(p_reqstr))
+    {
+        item.requirements.str = j[p_reqstr].get<int>();
+        item.set(field_req_str);
+    }
+
+    if (j.contains(p_reqdex))
+    {
+        item.requirements.dex = j[p_reqdex].get<int>();
+        item.set(field_req_dex);
+    }
+
+    if (j.contains(p_reqint))
+    {
+        item.requirements.intell = j[p_reqint].get<int>();
+        item.set(field_req_int);
+    }
+
+    if (j.contains(p_waps))
+    {
+        item.weapon.aps = j[p_waps].get<double>();
+        item.set(field_weapon_aps);
+    }
+
+    if (j.contains(p_wcrit))
+    {
+        item.weapon.crit = j[p_wcrit].get<double>();
+        item.set(field_weapon_crit);
+    }
+
+    if (j.contains(p_wpdps))
+    {
+        item.weapon.pdps = readRange(j[p_wpdps]);
+        item.set(field_weapon_pdps);
+    }
+
+    if (j.contains(p_wedps))
+    {
+        item.weapon.edps = readRange(j[p_wedps]);
+        item.set(field_weapon_edps);
+    }
+
+    if (j.contains(p_aar))
+    {
+        item.armour.ar = j[p_aar].get<int>();
+        item.set(field_armour_ar);
+    }
+
+    if (j.contains(p_aev))
+    {
+        item.armour.ev = j[p_aev].get<int>();
+        item.set(field_armour_ev);
+    }
+
+    if (j.contains(p_aes))
+    {
+        item.armour.es = j[p_aes].get<int>();
+        item.set(field_armour_es);
+    }
+
+    if (j.contains(p_ablock))
+    {
+        item.armour.block = j[p_ablock].get<int>();
+        item.set(field_armour_block);
+    }
+
+    if (j.contains(p_sockets))
+    {
+        const auto& s = j[p_sockets];
+
+        item.sockets.links = s.value("links", 0);
+        item.sockets.total = s.value("total", 0);
+        item.sockets.R     = s.value("R", 0);
+        item.sockets.G     = s.value("G", 0);
+        item.sockets.B     = s.value("B", 0);
+        item.sockets.W     = s.value("W", 0);
+        item.sockets.A     = s.value("A", 0);
+
+        item.set(field_sockets);
+    }
+
+    if (j.contains(p_mdisc))
+    {
+        item.misc.disc = j[p_mdisc].get<std::string>();
+        item.set(field_misc_disc);
+    }
+
+    if (j.contains(p_msynth) && j[p_msynth].get<bool>())
+    {
+        item.set(field_misc_synthesis);
+    }
+
+    if (j.contains(p_mglvl))
+    {
+        item.misc.gemLevel = j[p_mglvl].get<int>();
+        item.set(field_misc_gem_level);
+    }
+
+    if (j.contains(p_mgexp))
+    {
+        item.misc.gemProgress = j[p_mgexp].get<std::string>();
+        item.set(field_misc_gem_progress);
+    }
+
+    if (j.contains(p_mmtier))
+    {
+        item.misc.mapTier = j[p_mmtier].get<int>();
+        item.set(field_misc_map_tier);
+    }
+
+    if (gen && j.contains(p_filters) && j[p_filters].is_object())
+    {
+        readFilters(j[p_filters], gen->stats(), item.filters);
+    }
+
+    if (gen && j.contains(p_pseudos) && j[p_pseudos].is_object())
+    {
+        readFilters(j[p_pseudos], gen->stats(), item.pseudos);
+    }
+
+    return item;
+}
@@ -1,14 +1,217 @@
 #pragma once
 
+#include "dataset.h"
+
+#include <array>
+#include <bitset>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 using jptr = json::json_pointer;
-using Item = json;
+
+enum item_rarity_e : uint8_t
+{
+    rarity_normal = 0,
+    rarity_magic,
+    rarity_rare,
+    rarity_unique,
+    rarity_gem,
+    rarity_currency,
+    rarity_card,
+    rarity_quest,
+    rarity_unknown,
+    item_rarity_max
+};
+
+enum item_influence_e : uint8_t
+{
+    influence_shaper = 0,
+    influence_elder,
+    influence_crusader,
+    influence_redeemer,
+    influence_hunter,
+    influence_warlord,
+    influences_max
+};
+
+// Properties an item may or may not have
+enum item_field_e : uint32_t
+{
+    field_name         = 1u << 0,
+    field_quality      = 1u << 1,
+    field_ilvl         = 1u << 2,
+    field_unidentified = 1u << 3,
+    field_corrupted    = 1u << 4,
+
+    field_req_lvl = 1u << 5,
+    field_req_str = 1u << 6,
+    field_req_dex = 1u << 7,
+    field_req_int = 1u << 8,
+
+    field_weapon_aps  = 1u << 9,
+    field_weapon_crit = 1u << 10,
+    field_weapon_pdps = 1u << 11,
+    field_weapon_edps = 1u << 12,
+
+    field_armour_ar    = 1u << 13,
+    field_armour_ev    = 1u << 14,
+    field_armour_es    = 1u << 15,
+    field_armour_block = 1u << 16,
+
+    field_sockets = 1u << 17,
+
+    field_misc_disc         = 1u << 18,
+    field_misc_synthesis    = 1u << 19,
+    field_misc_gem_level    = 1u << 20,
+    field_misc_gem_progress = 1u << 21,
+    field_misc_map_tier     = 1u << 22,
+
+    // Groups
+    field_requirements = field_req_lvl | field_req_str | field_req_dex | field_req_int,
+    field_weapon       = field_weapon_aps | field_weapon_crit | field_weapon_pdps | field_weapon_edps,
+    field_armour       = field_armour_ar | field_armour_ev | field_armour_es | field_armour_block,
+    field_misc         = field_misc_disc | field_misc_synthesis | field_misc_gem_level | field_misc_gem_progress | field_misc_map_tier
+};
+
+struct IntRange
+{
+    int min = 0;
+    int max = 0;
+};
+
+// A stat of an item, resolved against the stat table of the item's generation
+struct ItemFilter
+{
+    static constexpr size_t max_values = 8;
+
+    StatTable::index_t             stat   = StatTable::npos;
+    std::array<double, max_values> values = {};
+    uint8_t                        count  = 0;
+    uint8_t                        real   = 0; // bit per value that is a float rather than an integer
+
+    // Set by the search UI
+    bool   enabled = false;
+    bool   hasMin  = false;
+    bool   hasMax  = false;
+    double min     = 0.0;
+    double max     = 0.0;
+
+    void push(double value, bool isReal);
+    bool isReal(size_t i) const { return (real & (1u << i)); }
+
+    // Filter entry as the search UI lists it
+    json toJson(const StatTable& stats) const;
+
+    // Stat filter of a trade query. The stat is only turned back into its id here
+    json toQueryJson(const StatTable& stats) const;
+};
+
+// A parsed item. Everything the parser reads is stored inline, the JSON form
+// (see the schema below) is only built for the search UI.
+struct Item
+{
+    // Generation the stat and base indices refer to
+    std::shared_ptr<const Dataset> gen;
+
+    uint32_t                    fields     = 0; // item_field_e
+    item_rarity_e               rarity     = rarity_unknown;
+    item_category_e             category   = cat_none;
+    BaseTable::index_t          base       = BaseTable::npos;
+    std::bitset<influences_max> influences = {};
+
+    std::string origtext;
+    std::string name;
+    std::string type;
+
+    int quality = 0;
+    int ilvl    = 0;
+
+    struct Requirements
+    {
+        int lvl    = 0;
+        int str    = 0;
+        int dex    = 0;
+        int intell = 0;
+    } requirements;
+
+    struct Weapon
+    {
+        double   aps  = 0.0;
+        double   crit = 0.0;
+        IntRange pdps;
+        IntRange edps;
+    } weapon;
+
+    struct Armour
+    {
+        int ar    = 0;
+        int ev    = 0;
+        int es    = 0;
+        int block = 0;
+    } armour;
+
+    struct Sockets
+    {
+        int links = 0;
+        int total = 0;
+        int R     = 0;
+        int G     = 0;
+        int B     = 0;
+        int W     = 0;
+        int A     = 0;
+    } sockets;
+
+    struct Misc
+    {
+        std::string disc;
+        std::string gemProgress;
+        int         gemLevel = 0;
+        int         mapTier  = 0;
+    } misc;
+
+    std::vector<ItemFilter> filters;
+    std::vector<ItemFilter> pseudos;
+
+    static constexpr std::array<const char*, item_rarity_max> rarity_names    = {
+        "Normal", "Magic", "Rare", "Unique", "Gem", "Currency", "card", "Quest", "Unknown"};
+    static constexpr std::array<const char*, influences_max>  influence_names = {"shaper", "elder", "crusader", "redeemer", "hunter", "warlord"};
+
+    static constexpr auto rarity_index    = perfect::names<item_rarity_e>(rarity_names);
+    static constexpr auto influence_index = perfect::names<item_influence_e>(influence_names);
+
+    bool has(uint32_t mask) const { return (fields & mask); }
+    void set(uint32_t mask) { fields |= mask; }
+
+    std::string_view rarityName() const { return rarity_names[rarity]; }
+    std::string_view categoryName() const;
+
+    ItemFilter*       filter(StatTable::index_t stat);
+    const ItemFilter* filter(StatTable::index_t stat) const;
+    ItemFilter*       pseudo(StatTable::index_t stat);
+
+    // Sums the filters up into pseudos by the compiled rules of gen
+    void computePseudos();
+
+    // Same for a batch of items parsed against one generation, sharing one buffer of totals
+    static void computePseudos(const std::vector<Item*>& items);
+
+    // Name the trade site lists the item by, the base type if it has no name
+    const std::string& searchName() const { return (has(field_name) ? name : type); }
+
+    json toJson() const;
+
+    // Reads back an item the search UI has worked on. Stats that do not exist in gen are dropped
+    static Item fromJson(const json& j, std::shared_ptr<const Dataset> gen);
+};
 
 /*
 
-JSON Item Schema
+JSON Item Schema, as written by Item::toJson
 
 {
     origtext: string,
@@ -69,11 +272,21 @@ JSON Item Schema
     },
 
     filters: {
-        ...PoE mod filters...
+        <stat id>: {
+            id: string,
+            stat: integer, // index into the stat table of the generation the item was parsed with
+            text: string,
+            type: string,
+            value: Array,
+            enabled: bool,
+            min: float,
+            max: float
+        },
+        ...
     },
 
     pseudos: {
-        ...PoE mod filters...
+        ...same as filters...
     }
 
 
@@ -107,6 +320,7 @@ JSON Data Schema
 */
 
 constexpr auto p_enabled = "enabled";
+constexpr auto p_stat    = "stat";
 constexpr auto p_item    = "item";
 constexpr auto p_results = "results";
 
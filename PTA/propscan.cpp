@@ -0,0 +1,382 @@
+#include "propscan.h"
+
+#include <array>
+#include <charconv>
+
+namespace
+{
+    constexpr std::string_view augmented_tag = " (augmented)";
+
+    bool isDigit(char c)
+    {
+        return (c >= '0' && c <= '9');
+    }
+
+    bool isNumeric(char c)
+    {
+        return (isDigit(c) || c == '.');
+    }
+
+    bool isSign(char c)
+    {
+        return (c == '+' || c == '-');
+    }
+
+    // Copy of a number for std::from_chars, which wants it in one piece without
+    // augmented tags. Nothing the game prints comes close to the size limit,
+    // longer numbers read as 0
+    class number_buffer
+    {
+    public:
+        void push(char c)
+        {
+            if (m_size < m_text.size())
+            {
+                m_text[m_size] = c;
+            }
+
+            m_size++;
+        }
+
+        bool empty() const { return (m_size == 0); }
+
+        template <typename T>
+        T to() const
+        {
+            if (m_size > m_text.size())
+            {
+                return T();
+            }
+
+            const char* first = m_text.data();
+            const char* last  = m_text.data() + m_size;
+
+            // from_chars does not take a plus sign
+            if (first != last && *first == '+')
+            {
+                first++;
+            }
+
+            T    value = T();
+            auto res   = std::from_chars(first, last, value);
+
+            // Like QString, only numbers that are read in full count
+            return (res.ec == std::errc() && res.ptr == last ? value : T());
+        }
+
+    private:
+        std::array<char, 64> m_text;
+        size_t               m_size = 0;
+    };
+
+    number_buffer copyNumber(std::string_view token)
+    {
+        number_buffer buf;
+
+        for (char c : token)
+        {
+            buf.push(c);
+        }
+
+        return buf;
+    }
+
+    // Reads a property value as if every " (augmented)" had been removed from it first
+    class prop_reader
+    {
+    public:
+        explicit prop_reader(std::string_view prop) : m_prop(prop) { skipTags(); }
+
+        bool done() const { return (m_pos == m_prop.size()); }
+        char peek() const { return m_prop[m_pos]; }
+
+        void next()
+        {
+            m_pos++;
+            skipTags();
+        }
+
+        // Leading run of the characters accepted by pred
+        template <typename Pred>
+        bool read(Pred pred, number_buffer& buf)
+        {
+            bool any = false;
+
+            while (!done() && pred(peek()))
+            {
+                buf.push(peek());
+                next();
+                any = true;
+            }
+
+            return any;
+        }
+
+    private:
+        void skipTags()
+        {
+            while (m_prop.substr(m_pos).starts_with(augmented_tag))
+            {
+                m_pos += augmented_tag.size();
+            }
+        }
+
+    private:
+        std::string_view m_prop;
+        size_t           m_pos = 0;
+    };
+
+    // Leading [+-]?[\d.]+ of a property value
+    bool readLeadingNumber(std::string_view prop, number_buffer& buf)
+    {
+        prop_reader r(prop);
+
+        if (!r.done() && isSign(r.peek()))
+        {
+            buf.push(r.peek());
+            r.next();
+        }
+
+        return r.read(isNumeric, buf);
+    }
+
+    // Leading (\d+)-(\d+) of a property value
+    IntRange readRange(std::string_view prop)
+    {
+        IntRange      val;
+        prop_reader   r(prop);
+        number_buffer lo, hi;
+
+        if (!r.read(isDigit, lo) || r.done() || r.peek() != '-')
+        {
+            return val;
+        }
+
+        r.next();
+
+        if (!r.read(isDigit, hi))
+        {
+            return val;
+        }
+
+        val.min = lo.to<int>();
+        val.max = hi.to<int>();
+
+        return val;
+    }
+
+    // Calls fn with every non-empty part of s between separators
+    template <typename Fn>
+    void forEachPart(std::string_view s, std::string_view sep, Fn fn)
+    {
+        size_t pos = 0;
+
+        while (pos <= s.size())
+        {
+            size_t end = s.find(sep, pos);
+
+            if (end == std::string_view::npos)
+            {
+                end = s.size();
+            }
+
+            if (end > pos)
+            {
+                fn(s.substr(pos, end - pos));
+            }
+
+            pos = end + sep.size();
+        }
+    }
+}
+
+namespace propscan
+{
+    bool nextNumber(std::string_view line, size_t& pos, std::string_view& token)
+    {
+        while (pos < line.size())
+        {
+            size_t start = pos;
+
+            if (isSign(line[pos]) && pos + 1 < line.size() && isNumeric(line[pos + 1]))
+            {
+                pos++;
+            }
+            else if (!isNumeric(line[pos]))
+            {
+                pos++;
+                continue;
+            }
+
+            while (pos < line.size() && isNumeric(line[pos]))
+            {
+                pos++;
+            }
+
+            token = line.substr(start, pos - start);
+            return true;
+        }
+
+        return false;
+    }
+
+    int toInt(std::string_view token)
+    {
+        return copyNumber(token).to<int>();
+    }
+
+    double toDouble(std::string_view token)
+    {
+        return copyNumber(token).to<double>();
+    }
+
+    int readInt(std::string_view prop)
+    {
+        number_buffer buf;
+        return (readLeadingNumber(prop, buf) ? buf.to<int>() : 0);
+    }
+
+    double readFloat(std::string_view prop)
+    {
+        number_buffer buf;
+        return (readLeadingNumber(prop, buf) ? buf.to<double>() : 0.0);
+    }
+
+    IntRange readIntRange(std::string_view prop)
+    {
+        IntRange val;
+
+        // Lists of ranges add up
+        forEachPart(prop, ", ", [&](std::string_view part) {
+            IntRange nxt = readRange(part);
+
+            val.min += nxt.min;
+            val.max += nxt.max;
+        });
+
+        return val;
+    }
+
+    Item::Sockets readSockets(std::string_view prop)
+    {
+        Item::Sockets sockets;
+
+        forEachPart(prop, " ", [&](std::string_view group) {
+            int count = 0;
+
+            forEachPart(group, "-", [&](std::string_view s) {
+                if (s == "R")
+                {
+                    sockets.R++;
+                }
+                else if (s == "G")
+                {
+                    sockets.G++;
+                }
+                else if (s == "B")
+                {
+                    sockets.B++;
+                }
+                else if (s == "W")
+                {
+                    sockets.W++;
+                }
+                else if (s == "A")
+                {
+                    sockets.A++;
+                }
+
+                sockets.total++;
+                count++;
+            });
+
+            if (count > 1 && count > sockets.links)
+            {
+                // New max links
+                sockets.links = count;
+            }
+        });
+
+        return sockets;
+    }
+
+    void readNumerics(std::string_view line, ItemFilter& val)
+    {
+        size_t           pos = 0;
+        std::string_view token;
+
+        while (nextNumber(line, pos, token))
+        {
+            if (token.find('.') != std::string_view::npos)
+            {
+                val.push(toDouble(token), true);
+            }
+            else
+            {
+                val.push(toInt(token), false);
+            }
+        }
+    }
+
+    bool matchesMasked(std::string_view line, std::string_view pattern, std::string_view mask)
+    {
+        size_t           pos  = 0;
+        size_t           last = 0;
+        size_t           at   = 0;
+        std::string_view token;
+
+        auto take = [&](std::string_view part) {
+            if (pattern.substr(at, part.size()) != part)
+            {
+                return false;
+            }
+
+            at += part.size();
+            return true;
+        };
+
+        while (nextNumber(line, pos, token))
+        {
+            size_t start = static_cast<size_t>(token.data() - line.data());
+
+            if (!take(line.substr(last, start - last)) || !take(mask))
+            {
+                return false;
+            }
+
+            last = pos;
+        }
+
+        return (take(line.substr(last)) && at == pattern.size());
+    }
+
+    size_t stripRolls(char* line, size_t size)
+    {
+        size_t out  = 0;
+        char   prev = 0;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            if (line[i] == '(' && isDigit(prev))
+            {
+                size_t end = i + 1;
+
+                while (end < size && (isNumeric(line[end]) || isSign(line[end])))
+                {
+                    end++;
+                }
+
+                if (end < size && end > i + 1 && line[end] == ')')
+                {
+                    i = end;
+                    continue;
+                }
+            }
+
+            prev        = line[i];
+            line[out++] = line[i];
+        }
+
+        return out;
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "pitem.h"
+
+#include <algorithm>
+#include <string_view>
+
+// Scanners for the numbers in item text, working on views into the UTF-8
+// text of an item without copying it.
+//
+// A number is what the item parser has always matched with [+-]?[\d.]+ and
+// converted with QString::toInt or QString::toDouble, which give 0 for
+// anything they cannot read in full (like "1.5" read as an int).
+namespace propscan
+{
+    // Finds the next number at or after pos, the same one a global regex match
+    // would find, and moves pos past it
+    bool nextNumber(std::string_view line, size_t& pos, std::string_view& token);
+
+    int    toInt(std::string_view token);
+    double toDouble(std::string_view token);
+
+    // Leading number of a property value like "+20% (augmented)"
+    int    readInt(std::string_view prop);
+    double readFloat(std::string_view prop);
+
+    // Sum of the "min-max" ranges of a property value like "12-24, 3-56 (augmented)"
+    IntRange readIntRange(std::string_view prop);
+
+    // Socket groups like "R-G-B B W"
+    Item::Sockets readSockets(std::string_view prop);
+
+    // Pushes every number in line, as a float if it has a decimal point
+    void readNumerics(std::string_view line, ItemFilter& val);
+
+    // Drops the roll ranges an advanced copy puts after numbers, like the
+    // "(40-49)" of "+45(40-49) to maximum Life", in place. Returns the new size
+    size_t stripRolls(char* line, size_t size);
+
+    // Whether line reads as pattern once every number in it is replaced by mask
+    bool matchesMasked(std::string_view line, std::string_view pattern, std::string_view mask);
+
+    // Lines of an item text, without their line breaks
+    class LineReader
+    {
+    public:
+        explicit LineReader(std::string_view text) : m_text(text) {}
+
+        bool atEnd() const { return (m_pos >= m_text.size()); }
+
+        // Moves to the next line, gives an empty line once there are none left
+        bool next(std::string_view& line)
+        {
+            if (atEnd())
+            {
+                line = std::string_view();
+                return false;
+            }
+
+            line  = current();
+            m_pos = std::min(m_text.size(), m_pos + line.size() + 1);
+
+            if (line.ends_with('\r'))
+            {
+                line.remove_suffix(1);
+            }
+
+            return true;
+        }
+
+        // Line next would give, without moving
+        std::string_view peek() const
+        {
+            std::string_view line = (atEnd() ? std::string_view() : current());
+            return (line.ends_with('\r') ? line.substr(0, line.size() - 1) : line);
+        }
+
+    private:
+        std::string_view current() const { return m_text.substr(m_pos, m_text.find('\n', m_pos) - m_pos); }
+
+    private:
+        std::string_view m_text;
+        size_t           m_pos = 0;
+    };
+}
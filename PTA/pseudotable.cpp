@@ -0,0 +1,89 @@
+#include "pseudotable.h"
+
+#include <algorithm>
+
+void PseudoTable::add(StatTable::index_t stat, StatTable::index_t pseudo, double factor, bool add)
+{
+    std::vector<StatTable::index_t>& pseudos = m_pseudos.owned();
+
+    auto it = std::find(pseudos.begin(), pseudos.end(), pseudo);
+
+    if (it == pseudos.end())
+    {
+        it = pseudos.insert(pseudos.end(), pseudo);
+    }
+
+    m_rules.push_back({stat, {factor, static_cast<slot_t>(std::distance(pseudos.begin(), it)), add}});
+}
+
+void PseudoTable::seal(size_t statCount)
+{
+    // Rows in stat order, rules in the order they were added within a row
+    std::stable_sort(m_rules.begin(), m_rules.end(), [](const rule& a, const rule& b) { return a.stat < b.stat; });
+
+    std::vector<uint32_t> rowBegin(statCount + 1, 0);
+    std::vector<term>     terms;
+
+    terms.reserve(m_rules.size());
+
+    size_t r = 0;
+
+    for (size_t s = 0; s < statCount; s++)
+    {
+        rowBegin[s] = static_cast<uint32_t>(terms.size());
+
+        for (; r < m_rules.size() && m_rules[r].stat == s; r++)
+        {
+            terms.push_back(m_rules[r].t);
+        }
+    }
+
+    rowBegin[statCount] = static_cast<uint32_t>(terms.size());
+
+    m_rowBegin.assign(std::move(rowBegin));
+    m_terms.assign(std::move(terms));
+
+    m_rules.clear();
+    m_rules.shrink_to_fit();
+}
+
+void PseudoTable::clear()
+{
+    m_rowBegin.clear();
+    m_terms.clear();
+    m_pseudos.clear();
+    m_rules.clear();
+}
+
+void PseudoTable::save(ptadb::SectionWriter& w) const
+{
+    w.array(m_rowBegin);
+    w.array(m_terms);
+    w.array(m_pseudos);
+}
+
+bool PseudoTable::restore(ptadb::SectionReader& r)
+{
+    clear();
+
+    bool ok = r.array(m_rowBegin) && r.array(m_terms) && r.array(m_pseudos) && (m_rowBegin.empty() || m_rowBegin.back() == m_terms.size());
+
+    if (!ok)
+    {
+        clear();
+    }
+
+    return ok;
+}
+
+std::pair<const PseudoTable::term*, const PseudoTable::term*> PseudoTable::terms(StatTable::index_t stat) const
+{
+    if (m_rowBegin.empty() || stat >= m_rowBegin.size() - 1)
+    {
+        return {nullptr, nullptr};
+    }
+
+    const term* base = m_terms.data();
+
+    return {base + m_rowBegin[stat], base + m_rowBegin[stat + 1]};
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ptadb.h"
+#include "stattable.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// The pseudo stat rules.
+//
+// Every rule says that a stat counts towards a pseudo stat with some factor.
+// The rules form a sparse matrix from stat index to (pseudo slot, factor),
+// stored row by row, so the rules of a stat are a single range. Pseudo stats
+// are numbered with dense slots, which lets an item sum up its pseudo totals
+// in one small buffer indexed by slot.
+class PseudoTable
+{
+public:
+    using slot_t = uint16_t;
+
+    struct term
+    {
+        double  factor;
+        slot_t  pseudo;
+        bool    add;             // whether the values of more stats add up, otherwise the first one stays
+        uint8_t reserved[5] = {};
+    };
+
+    // Adds a rule. terms() is only available after seal()
+    void add(StatTable::index_t stat, StatTable::index_t pseudo, double factor, bool add);
+
+    // Builds the rows for a stat table of statCount stats
+    void seal(size_t statCount);
+    void clear();
+
+    void save(ptadb::SectionWriter& w) const;
+    bool restore(ptadb::SectionReader& r);
+
+    size_t size() const { return m_terms.size(); }
+    size_t slots() const { return m_pseudos.size(); }
+
+    StatTable::index_t stat(slot_t s) const { return m_pseudos[s]; }
+
+    // Terms a stat feeds, in rule order
+    std::pair<const term*, const term*> terms(StatTable::index_t stat) const;
+
+private:
+    struct rule
+    {
+        StatTable::index_t stat;
+        term               t;
+    };
+
+    ptadb::array<uint32_t>           m_rowBegin; // statCount + 1 entries into m_terms
+    ptadb::array<term>               m_terms;
+    ptadb::array<StatTable::index_t> m_pseudos; // stat of every slot
+
+    // Build time only
+    std::vector<rule> m_rules;
+};
+
+static_assert(sizeof(PseudoTable::term) == 16, "PseudoTable::term has padding");
+
+template <>
+inline constexpr bool ptadb::packed<PseudoTable::term> = true;
@@ -61,6 +61,14 @@ PTA::PTA(LogWindow* log, QWidget* parent) :
         qApp->exit(1);
     }
 
+    connect(m_api, &ItemAPI::loadFailed, this, [=](const QString& error) {
+        QMessageBox::critical(nullptr, tr("Critical Error"), error, QMessageBox::Abort);
+        qApp->exit(1);
+    });
+
+    // Only hold up startup for what a currency check needs, the rest loads in the background
+    m_api->waitForTier(tier_core);
+
     // Setup system tray
     createActions();
     createTrayIcon();
@@ -201,6 +209,22 @@ void PTA::setupFunctionality()
     connect(m_api, &ItemAPI::humour, this, &PTA::showToolTip);
     connect(m_api, &ItemAPI::simpleResultsFinished, this, &PTA::showPriceWidget);
 
+    // Run a price check that was waiting on data
+    connect(m_api, &ItemAPI::tierReady, this, [=]() {
+        if (m_pendingText.isEmpty() || !m_api->isReady(m_pendingTier))
+        {
+            return;
+        }
+
+        QString itemText = m_pendingText;
+        m_pendingText.clear();
+
+        if (pta::IsPoEForeground())
+        {
+            priceCheck(itemText, m_pendingType);
+        }
+    });
+
     connect(&m_macrohandler, &MacroHandler::humour, this, &PTA::showToolTip);
 
     // Hotkeys
@@ -485,7 +509,11 @@ void PTA::handleItemHotkey(uint32_t flag)
         }
     });
 
-    // Send ctrl-c
+    // Send ctrl-c, or ctrl-alt-c for the advanced item description
+    QSettings settings;
+
+    bool advancedCopy = settings.value(PTA_CONFIG_ADVANCED_COPY_ENABLED, false).toBool();
+
     std::vector<INPUT> keystroke;
 
     // ensure ctrl/alt/c is up
@@ -494,8 +522,20 @@ void PTA::handleItemHotkey(uint32_t flag)
     keystroke.push_back(pta::CreateInput('C', false));
 
     keystroke.push_back(pta::CreateInput(VK_CONTROL, true));
+
+    if (advancedCopy)
+    {
+        keystroke.push_back(pta::CreateInput(VK_MENU, true));
+    }
+
     keystroke.push_back(pta::CreateInput('C', true));
     keystroke.push_back(pta::CreateInput('C', false));
+
+    if (advancedCopy)
+    {
+        keystroke.push_back(pta::CreateInput(VK_MENU, false));
+    }
+
     keystroke.push_back(pta::CreateInput(VK_CONTROL, false));
 
     SendInput(keystroke.size(), keystroke.data(), sizeof(keystroke[0]));
@@ -561,6 +601,24 @@ void PTA::processClipboard()
         }
     }
 
+    data_tier tier = m_api->requiredTier(itemText);
+
+    if (!m_api->isReady(tier))
+    {
+        // Only the latest check is kept
+        m_pendingText = itemText;
+        m_pendingType = m_pctype;
+        m_pendingTier = tier;
+
+        showToolTip(tr("Game data is still loading. The search will start once it is ready."));
+        return;
+    }
+
+    priceCheck(itemText, m_pctype);
+}
+
+void PTA::priceCheck(const QString& itemText, uint32_t type)
+{
     showToolTip("Searching...");
 
     Item item;
@@ -574,23 +632,23 @@ void PTA::processClipboard()
 
     json data = json::object();
 
-    data[p_item] = item;
+    data[p_item] = item.toJson();
 
-    m_api->fillItemOptions(data);
+    m_api->fillItemOptions(item, data);
 
     QString strdata = QString::fromStdString(data.dump());
 
-    switch (m_pctype)
+    switch (type)
     {
         case PC_ADVANCED:
             data["tab"] = "mods";
 
         case PC_SIMPLE:
             // If simple price check not handled
-            if (!m_api->trySimplePriceCheck(data))
+            if (!m_api->trySimplePriceCheck(item, data))
             {
                 // If item has filters and is not a map and is not unid'd
-                if (item.contains(p_filters) && item[p_category] != "map" && !item.contains(p_unidentified))
+                if (!item.filters.empty() && item.category != cat_map && !item.has(field_unidentified))
                 {
                     // Load the price UI for advanced search
 
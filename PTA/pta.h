@@ -18,6 +18,8 @@
 QT_FORWARD_DECLARE_CLASS(LogWindow)
 QT_FORWARD_DECLARE_CLASS(ItemAPI)
 
+enum data_tier : uint8_t;
+
 enum search_check_flag : uint32_t
 {
     PC_SIMPLE = 0,
@@ -79,6 +81,7 @@ private slots:
     void handleItemHotkey(uint32_t flag);
     void handleClipboard();
     void processClipboard();
+    void priceCheck(const QString& itemText, uint32_t type);
     void handleForegroundChange(bool isPoe);
 
     void processUpdates(QNetworkReply* reply);
@@ -126,6 +129,11 @@ private:
     bool     m_pcTriggered  = false;
     uint32_t m_pctype;
 
+    // Price check waiting for its data tier
+    QString   m_pendingText;
+    uint32_t  m_pendingType;
+    data_tier m_pendingTier;
+
     ConfigDialog* m_configdialog = nullptr;
 
     Q_DISABLE_COPY(PTA);
@@ -9,8 +9,10 @@ enum pta_log_level_t
 };
 
 // Config defs
-constexpr auto PTA_CONFIG_LOGLEVEL = "global/loglevel";
-constexpr auto PTA_CONFIG_LOGFILE  = "global/logfile";
+constexpr auto PTA_CONFIG_LOGLEVEL            = "global/loglevel";
+constexpr auto PTA_CONFIG_LOGFILE             = "global/logfile";
+constexpr auto PTA_CONFIG_STARTUP_REPORT      = "global/startupreport";
+constexpr auto PTA_CONFIG_PERSIST_PARSE_CACHE = "global/persistparsecache";
 
 constexpr auto PTA_CONFIG_PRICE_TEMPLATE = "ui/pricetemplate";
 
@@ -21,6 +23,7 @@ constexpr auto PTA_CONFIG_ADV_CHECK_HOTKEY_ENABLED    = "hotkey/advcheck/enabled
 constexpr auto PTA_CONFIG_WIKI_HOTKEY                 = "hotkey/wiki";
 constexpr auto PTA_CONFIG_WIKI_HOTKEY_ENABLED         = "hotkey/wiki/enabled";
 constexpr auto PTA_CONFIG_CTRL_SCROLL_HOTKEY_ENABLED  = "hotkey/cscroll/enabled";
+constexpr auto PTA_CONFIG_ADVANCED_COPY_ENABLED       = "hotkey/advancedcopy/enabled";
 
 constexpr auto PTA_CONFIG_LEAGUE             = "pricecheck/league";
 constexpr auto PTA_CONFIG_DISPLAYLIMIT       = "pricecheck/displaylimit";
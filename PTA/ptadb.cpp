@@ -0,0 +1,325 @@
+#include "ptadb.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    struct file_header
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t section_count;
+    };
+
+    struct dir_entry
+    {
+        uint32_t id;
+        uint32_t reserved;
+        uint64_t hash;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    static_assert(sizeof(file_header) == 16);
+    static_assert(sizeof(dir_entry) == 32);
+
+    constexpr size_t align8(size_t v)
+    {
+        return (v + 7) & ~size_t(7);
+    }
+}
+
+namespace ptadb
+{
+    uint64_t hash(const char* data, size_t size, uint64_t seed)
+    {
+        uint64_t h = seed;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            h ^= static_cast<uint8_t>(data[i]);
+            h *= 0x100000001b3ULL;
+        }
+
+        return h;
+    }
+
+    ///////////////////////////////////////////// SectionWriter
+
+    void SectionWriter::u8(uint8_t v)
+    {
+        m_records.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    void SectionWriter::u32(uint32_t v)
+    {
+        m_records.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    void SectionWriter::u64(uint64_t v)
+    {
+        m_records.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    void SectionWriter::str(std::string_view v)
+    {
+        uint32_t offset;
+
+        auto it = m_interned.find(std::string(v));
+        if (it != m_interned.end())
+        {
+            offset = it->second;
+        }
+        else
+        {
+            offset = static_cast<uint32_t>(m_pool.size());
+            m_pool.append(v);
+            m_interned.insert({std::string(v), offset});
+        }
+
+        u32(offset);
+        u32(static_cast<uint32_t>(v.size()));
+    }
+
+    void SectionWriter::bytes(const void* data, size_t size)
+    {
+        m_pool.resize(align8(m_pool.size()), '\0');
+
+        uint32_t offset = static_cast<uint32_t>(m_pool.size());
+        m_pool.append(static_cast<const char*>(data), size);
+
+        u32(offset);
+        u32(static_cast<uint32_t>(size));
+    }
+
+    std::string SectionWriter::data() const
+    {
+        std::string out;
+
+        uint64_t recsize = m_records.size();
+
+        out.reserve(sizeof(recsize) + align8(m_records.size()) + m_pool.size());
+        out.append(reinterpret_cast<const char*>(&recsize), sizeof(recsize));
+        out.append(m_records);
+        out.resize(sizeof(recsize) + align8(m_records.size()), '\0');
+        out.append(m_pool);
+
+        return out;
+    }
+
+    ///////////////////////////////////////////// SectionReader
+
+    SectionReader::SectionReader(const char* data, size_t size)
+    {
+        uint64_t recsize;
+
+        if (size < sizeof(recsize))
+        {
+            return;
+        }
+
+        std::memcpy(&recsize, data, sizeof(recsize));
+
+        if (recsize > size - sizeof(recsize))
+        {
+            return;
+        }
+
+        // The pool starts 8 byte aligned, a section without one may end right after its records
+        size_t pool = std::min(sizeof(recsize) + align8(recsize), size);
+
+        m_records  = data + sizeof(recsize);
+        m_recsize  = recsize;
+        m_pool     = data + pool;
+        m_poolsize = size - pool;
+        m_valid    = true;
+    }
+
+    bool SectionReader::read(void* dst, size_t size)
+    {
+        if (!m_valid || m_recsize - m_pos < size)
+        {
+            m_valid = false;
+            return false;
+        }
+
+        std::memcpy(dst, m_records + m_pos, size);
+        m_pos += size;
+
+        return true;
+    }
+
+    bool SectionReader::u8(uint8_t& v)
+    {
+        return read(&v, sizeof(v));
+    }
+
+    bool SectionReader::u32(uint32_t& v)
+    {
+        return read(&v, sizeof(v));
+    }
+
+    bool SectionReader::u64(uint64_t& v)
+    {
+        return read(&v, sizeof(v));
+    }
+
+    bool SectionReader::str(std::string_view& v)
+    {
+        uint32_t offset, length;
+
+        if (!u32(offset) || !u32(length))
+        {
+            return false;
+        }
+
+        if (offset > m_poolsize || length > m_poolsize - offset)
+        {
+            m_valid = false;
+            return false;
+        }
+
+        v = std::string_view(m_pool + offset, length);
+
+        return true;
+    }
+
+    bool SectionReader::bytes(const char*& data, size_t& size, size_t align)
+    {
+        uint32_t offset, length;
+
+        if (!u32(offset) || !u32(length))
+        {
+            return false;
+        }
+
+        if (offset > m_poolsize || length > m_poolsize - offset || reinterpret_cast<uintptr_t>(m_pool + offset) % align)
+        {
+            m_valid = false;
+            return false;
+        }
+
+        data = m_pool + offset;
+        size = length;
+
+        return true;
+    }
+
+    ///////////////////////////////////////////// Writer
+
+    void Writer::add(uint32_t id, uint64_t hash, const SectionWriter& section)
+    {
+        m_sections.push_back({id, hash, section.data()});
+    }
+
+    size_t Writer::size(uint32_t id) const
+    {
+        for (const auto& e : m_sections)
+        {
+            if (e.id == id)
+            {
+                return e.data.size();
+            }
+        }
+
+        return 0;
+    }
+
+    std::string Writer::finish() const
+    {
+        std::string out;
+
+        file_header header = {};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version       = version;
+        header.section_count = static_cast<uint32_t>(m_sections.size());
+
+        size_t offset = align8(sizeof(header) + sizeof(dir_entry) * m_sections.size());
+
+        std::vector<dir_entry> dir;
+
+        for (const auto& s : m_sections)
+        {
+            dir.push_back({s.id, 0, s.hash, offset, s.data.size()});
+            offset = align8(offset + s.data.size());
+        }
+
+        out.reserve(offset);
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.append(reinterpret_cast<const char*>(dir.data()), sizeof(dir_entry) * dir.size());
+
+        for (size_t i = 0; i < m_sections.size(); i++)
+        {
+            out.resize(dir[i].offset, '\0');
+            out.append(m_sections[i].data);
+        }
+
+        return out;
+    }
+
+    ///////////////////////////////////////////// Reader
+
+    bool Reader::open(const char* data, size_t size, std::shared_ptr<const void> backing)
+    {
+        m_sections.clear();
+        m_backing.reset();
+
+        file_header header;
+
+        if (size < sizeof(header))
+        {
+            return false;
+        }
+
+        std::memcpy(&header, data, sizeof(header));
+
+        if (std::memcmp(header.magic, magic, sizeof(magic)) || header.version != version)
+        {
+            return false;
+        }
+
+        if (header.section_count > (size - sizeof(header)) / sizeof(dir_entry))
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < header.section_count; i++)
+        {
+            dir_entry e;
+            std::memcpy(&e, data + sizeof(header) + i * sizeof(dir_entry), sizeof(e));
+
+            if (e.offset > size || e.size > size - e.offset)
+            {
+                m_sections.clear();
+                return false;
+            }
+
+            m_sections[e.id] = {e.hash, e.offset, e.size};
+        }
+
+        m_data    = data;
+        m_size    = size;
+        m_backing = std::move(backing);
+
+        return true;
+    }
+
+    uint64_t Reader::hash(uint32_t id) const
+    {
+        auto it = m_sections.find(id);
+        return (it != m_sections.end() ? it->second.hash : 0);
+    }
+
+    SectionReader Reader::section(uint32_t id) const
+    {
+        auto it = m_sections.find(id);
+
+        if (it == m_sections.end())
+        {
+            return SectionReader();
+        }
+
+        return SectionReader(m_data + it->second.offset, it->second.size);
+    }
+}
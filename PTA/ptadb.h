@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/*
+
+PTA dataset snapshot (.ptadb)
+
+A flat binary image of the built lookup tables that is read in place from a
+memory mapped file: a restored table points its arrays straight into the
+mapping instead of copying or rebuilding them. All integers are host order,
+all offsets are relative to the start of the file and every section is 8 byte
+aligned.
+
+    header    { magic[8], version: u32, section_count: u32 }
+    directory { id: u32, reserved: u32, hash: u64, offset: u64, size: u64 }[section_count]
+    sections  ...
+
+Each section holds a block of fixed size records followed by the pool the
+records point into, which starts at the next 8 byte boundary:
+
+    section   { record_size: u64, records[record_size], padding, pool[] }
+
+Strings and arrays are stored in records as { offset: u32, length: u32 } into
+the section pool, length in bytes. Arrays hold the raw elements of the sealed
+tables (trie nodes and edges, index and value arrays, hash slots) and are 8
+byte aligned within the pool so they can be used where they are.
+
+*/
+
+namespace ptadb
+{
+    // Bump whenever the layout of any section changes, including the element
+    // types of the arrays the tables store
+    constexpr uint32_t version = 4;
+
+    constexpr char magic[8] = {'P', 'T', 'A', 'D', 'B', '\x1a', '\0', '\0'};
+
+    // 64-bit FNV-1a, used to fingerprint the source documents of each section
+    constexpr uint64_t hash_seed = 0xcbf29ce484222325ULL;
+
+    uint64_t hash(const char* data, size_t size, uint64_t seed = hash_seed);
+
+    inline uint64_t hash(std::string_view s, uint64_t seed = hash_seed)
+    {
+        return hash(s.data(), s.size(), seed);
+    }
+
+    // Whether every byte of a T belongs to one of its members, so arrays of them can be
+    // written as they are. Padding would be written uninitialized and differ from run to
+    // run. Types holding a floating point value do not count, they opt in once their
+    // padding is spelled out as zeroed members
+    template <typename T>
+    inline constexpr bool packed = std::has_unique_object_representations_v<T>;
+
+    // Elements of a table that are either owned or viewed in place in a mapped snapshot.
+    // Tables build into the owned form, see SectionReader::array for the other
+    template <typename T>
+    class array
+    {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 8, "arrays are stored as raw bytes");
+
+    public:
+        array() = default;
+        array(std::initializer_list<T> init) : m_owned(init) {}
+
+        const T* data() const { return (m_viewed ? m_view : m_owned.data()); }
+        size_t   size() const { return (m_viewed ? m_viewSize : m_owned.size()); }
+        bool     empty() const { return !size(); }
+
+        const T& operator[](size_t i) const { return data()[i]; }
+        const T& back() const { return data()[size() - 1]; }
+        const T* begin() const { return data(); }
+        const T* end() const { return data() + size(); }
+
+        // Elements to build into. A viewed array is copied out first
+        std::vector<T>& owned()
+        {
+            if (m_viewed)
+            {
+                m_owned.assign(m_view, m_view + m_viewSize);
+                m_viewed = false;
+            }
+
+            return m_owned;
+        }
+
+        void push_back(const T& v) { owned().push_back(v); }
+        void assign(std::vector<T>&& v)
+        {
+            m_owned  = std::move(v);
+            m_viewed = false;
+        }
+
+        // Points the array at elements that outlive it
+        void view(const T* data, size_t size)
+        {
+            m_owned    = std::vector<T>();
+            m_view     = data;
+            m_viewSize = size;
+            m_viewed   = true;
+        }
+
+        void clear()
+        {
+            m_owned.clear();
+            m_viewed = false;
+        }
+
+    private:
+        std::vector<T> m_owned;
+        const T*       m_view     = nullptr;
+        size_t         m_viewSize = 0;
+        bool           m_viewed   = false;
+    };
+
+    // Open addressing index from keys to the entries of a table. The slots are a flat
+    // array of entry numbers, so a sealed index is saved and restored like any other
+    // array. Keys are hashed with ptadb::hash, which is the same on every run, and are
+    // compared by the owner through the entries themselves.
+    class hash_index
+    {
+    public:
+        static constexpr uint32_t npos = UINT32_MAX;
+
+        // Sizes an empty index for count entries
+        void reserve(size_t count)
+        {
+            std::vector<uint32_t> slots(std::bit_ceil(std::max<size_t>(count * 2, 8)), npos);
+            m_slots.assign(std::move(slots));
+        }
+
+        void clear() { m_slots.clear(); }
+        bool empty() const { return m_slots.empty(); }
+
+        // Adds entry under hash h, unless same(e) holds for an entry e already in.
+        // The index has to be reserved for every entry added to it
+        template <typename SameFn>
+        bool insert(uint64_t h, uint32_t entry, SameFn same)
+        {
+            std::vector<uint32_t>& slots = m_slots.owned();
+            size_t                 mask  = slots.size() - 1;
+
+            for (size_t i = h & mask;; i = (i + 1) & mask)
+            {
+                if (slots[i] == npos)
+                {
+                    slots[i] = entry;
+                    return true;
+                }
+
+                if (same(slots[i]))
+                {
+                    return false;
+                }
+            }
+        }
+
+        // First entry e under hash h for which match(e) holds, npos if there is none
+        template <typename MatchFn>
+        uint32_t find(uint64_t h, MatchFn match) const
+        {
+            if (m_slots.empty())
+            {
+                return npos;
+            }
+
+            size_t mask = m_slots.size() - 1;
+
+            for (size_t i = h & mask; m_slots[i] != npos; i = (i + 1) & mask)
+            {
+                if (match(m_slots[i]))
+                {
+                    return m_slots[i];
+                }
+            }
+
+            return npos;
+        }
+
+        const array<uint32_t>& slots() const { return m_slots; }
+
+        // Takes over the slots of a saved index, false if they cannot be one
+        bool restore(const array<uint32_t>& slots)
+        {
+            if (!slots.empty() && !std::has_single_bit(slots.size()))
+            {
+                return false;
+            }
+
+            m_slots = slots;
+            return true;
+        }
+
+    private:
+        array<uint32_t> m_slots; // entry per slot, npos if free
+    };
+
+    class SectionWriter
+    {
+    public:
+        void u8(uint8_t v);
+        void u32(uint32_t v);
+        void u64(uint64_t v);
+        void str(std::string_view v);
+
+        template <typename T>
+        void array(const ptadb::array<T>& v)
+        {
+            static_assert(packed<T>, "array elements are written with their padding, see ptadb::packed");
+
+            bytes(v.data(), v.size() * sizeof(T));
+        }
+
+        std::string data() const;
+
+    private:
+        // Raw bytes in the pool at an 8 byte boundary
+        void bytes(const void* data, size_t size);
+
+    private:
+        std::string                               m_records;
+        std::string                               m_pool;
+        std::unordered_map<std::string, uint32_t> m_interned;
+    };
+
+    class SectionReader
+    {
+    public:
+        SectionReader() = default;
+        SectionReader(const char* data, size_t size);
+
+        bool valid() const { return m_valid; }
+        bool atEnd() const { return m_pos == m_recsize; }
+
+        bool u8(uint8_t& v);
+        bool u32(uint32_t& v);
+        bool u64(uint64_t& v);
+        bool str(std::string_view& v);
+
+        // Views an array in place, the section data has to outlive it
+        template <typename T>
+        bool array(ptadb::array<T>& v)
+        {
+            const char* data;
+            size_t      size;
+
+            if (!bytes(data, size, alignof(T)) || size % sizeof(T))
+            {
+                m_valid = false;
+                return false;
+            }
+
+            v.view(reinterpret_cast<const T*>(data), size / sizeof(T));
+            return true;
+        }
+
+    private:
+        bool read(void* dst, size_t size);
+        bool bytes(const char*& data, size_t& size, size_t align);
+
+    private:
+        const char* m_records  = nullptr;
+        const char* m_pool     = nullptr;
+        size_t      m_recsize  = 0;
+        size_t      m_poolsize = 0;
+        size_t      m_pos      = 0;
+        bool        m_valid    = false;
+    };
+
+    class Writer
+    {
+    public:
+        void add(uint32_t id, uint64_t hash, const SectionWriter& section);
+
+        // Size of a section added so far, 0 if there is none
+        size_t size(uint32_t id) const;
+
+        std::string finish() const;
+
+    private:
+        struct entry
+        {
+            uint32_t    id;
+            uint64_t    hash;
+            std::string data;
+        };
+
+        std::vector<entry> m_sections;
+    };
+
+    class Reader
+    {
+    public:
+        // data must outlive the reader and everything read from it. Tables that view their
+        // arrays in data hold on to backing, which is whatever keeps data around
+        bool open(const char* data, size_t size, std::shared_ptr<const void> backing = nullptr);
+
+        const std::shared_ptr<const void>& backing() const { return m_backing; }
+
+        bool          contains(uint32_t id) const { return m_sections.contains(id); }
+        uint64_t      hash(uint32_t id) const;
+        SectionReader section(uint32_t id) const;
+
+    private:
+        struct entry
+        {
+            uint64_t hash;
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        const char*                         m_data = nullptr;
+        size_t                              m_size = 0;
+        std::shared_ptr<const void>         m_backing;
+        std::unordered_map<uint32_t, entry> m_sections;
+    };
+}
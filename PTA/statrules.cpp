@@ -0,0 +1,237 @@
+#include "statrules.h"
+
+#include <algorithm>
+
+void LocalTable::add(const StatTable& stats, std::string_view text)
+{
+    auto local = stats.byText(std::string(text) + " (Local)");
+
+    if (local.first == local.second || !m_added.insert(std::string(text)).second)
+    {
+        return;
+    }
+
+    StatTable::index_t alt = *local.first;
+
+    m_text.push_back(m_strings.intern(text));
+    m_textAlternate.push_back(alt);
+
+    if (m_alternate.empty())
+    {
+        m_alternate.assign(std::vector<StatTable::index_t>(stats.size(), StatTable::npos));
+    }
+
+    std::vector<StatTable::index_t>& alternates = m_alternate.owned();
+
+    auto range = stats.byText(text);
+
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        alternates[*it] = alt;
+    }
+}
+
+void LocalTable::seal()
+{
+    m_strings.seal();
+    m_added.clear();
+
+    m_byText.reserve(size());
+
+    // Texts were only added once
+    for (uint32_t i = 0; i < size(); i++)
+    {
+        m_byText.insert(ptadb::hash(text(i)), i, [](uint32_t) { return false; });
+    }
+}
+
+void LocalTable::clear()
+{
+    m_alternate.clear();
+    m_strings.clear();
+    m_text.clear();
+    m_textAlternate.clear();
+    m_byText.clear();
+    m_added.clear();
+}
+
+void LocalTable::save(ptadb::SectionWriter& w) const
+{
+    w.array(m_alternate);
+    m_strings.save(w);
+    w.array(m_text);
+    w.array(m_textAlternate);
+    w.array(m_byText.slots());
+}
+
+bool LocalTable::restore(ptadb::SectionReader& r)
+{
+    clear();
+
+    ptadb::array<uint32_t> byText;
+
+    bool ok = r.array(m_alternate) && m_strings.restore(r) && r.array(m_text) && r.array(m_textAlternate) && r.array(byText) && m_byText.restore(byText) &&
+              m_textAlternate.size() == size();
+
+    if (!ok)
+    {
+        clear();
+    }
+
+    return ok;
+}
+
+StatTable::index_t LocalTable::alternate(std::string_view text) const
+{
+    uint32_t i = m_byText.find(ptadb::hash(text), [&](uint32_t e) { return this->text(e) == text; });
+    return (i != ptadb::hash_index::npos ? m_textAlternate[i] : StatTable::npos);
+}
+
+void DiscriminatorTable::add(StatTable::index_t stat, std::string_view category)
+{
+    std::vector<uint32_t>& masks = m_masks.owned();
+
+    if (stat >= masks.size())
+    {
+        masks.resize(stat + 1, 0);
+    }
+
+    if (auto cat = BaseTable::category_index.find(category))
+    {
+        masks[stat] |= (1u << *cat);
+    }
+    else
+    {
+        masks[stat] |= other_bit;
+        m_other.push_back({stat, m_strings.intern(category)});
+    }
+}
+
+void DiscriminatorTable::seal(size_t statCount)
+{
+    std::vector<uint32_t>& masks = m_masks.owned();
+
+    masks.resize(statCount, 0);
+    masks.shrink_to_fit();
+
+    m_strings.seal();
+}
+
+void DiscriminatorTable::clear()
+{
+    m_masks.clear();
+    m_strings.clear();
+    m_other.clear();
+}
+
+void DiscriminatorTable::save(ptadb::SectionWriter& w) const
+{
+    w.array(m_masks);
+    m_strings.save(w);
+    w.array(m_other);
+}
+
+bool DiscriminatorTable::restore(ptadb::SectionReader& r)
+{
+    clear();
+
+    bool ok = r.array(m_masks) && m_strings.restore(r) && r.array(m_other);
+
+    if (!ok)
+    {
+        clear();
+    }
+
+    return ok;
+}
+
+size_t DiscriminatorTable::size() const
+{
+    return std::count_if(m_masks.begin(), m_masks.end(), [](uint32_t m) { return m != 0; });
+}
+
+bool DiscriminatorTable::excludesOther(StatTable::index_t stat, std::string_view categoryName) const
+{
+    return std::any_of(m_other.begin(), m_other.end(), [&](const other& o) { return (o.stat == stat && m_strings.view(o.category) == categoryName); });
+}
+
+void EnchantTable::add(const StatTable& stats, std::string_view text, const rule& r)
+{
+    if (!m_added.insert(std::string(text)).second)
+    {
+        return;
+    }
+
+    uint32_t idx = static_cast<uint32_t>(m_rules.size());
+
+    m_rules.push_back(r);
+    m_text.push_back(m_strings.intern(text));
+
+    auto range = stats.byText(text);
+
+    if (range.first != range.second && m_byStat.empty())
+    {
+        m_byStat.assign(std::vector<uint32_t>(stats.size(), none));
+    }
+
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        m_byStat.owned()[*it] = idx;
+    }
+}
+
+void EnchantTable::seal()
+{
+    m_strings.seal();
+    m_added.clear();
+
+    m_byText.reserve(size());
+
+    // Texts were only added once
+    for (uint32_t i = 0; i < size(); i++)
+    {
+        m_byText.insert(ptadb::hash(text(i)), i, [](uint32_t) { return false; });
+    }
+}
+
+void EnchantTable::clear()
+{
+    m_rules.clear();
+    m_byStat.clear();
+    m_strings.clear();
+    m_text.clear();
+    m_byText.clear();
+    m_added.clear();
+}
+
+void EnchantTable::save(ptadb::SectionWriter& w) const
+{
+    w.array(m_rules);
+    w.array(m_byStat);
+    m_strings.save(w);
+    w.array(m_text);
+    w.array(m_byText.slots());
+}
+
+bool EnchantTable::restore(ptadb::SectionReader& r)
+{
+    clear();
+
+    ptadb::array<uint32_t> byText;
+
+    bool ok = r.array(m_rules) && r.array(m_byStat) && m_strings.restore(r) && r.array(m_text) && r.array(byText) && m_byText.restore(byText) &&
+              m_text.size() == size();
+
+    if (!ok)
+    {
+        clear();
+    }
+
+    return ok;
+}
+
+const EnchantTable::rule* EnchantTable::find(std::string_view text) const
+{
+    uint32_t i = m_byText.find(ptadb::hash(text), [&](uint32_t e) { return this->text(e) == text; });
+    return (i != ptadb::hash_index::npos ? &m_rules[i] : nullptr);
+}
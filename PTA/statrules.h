@@ -0,0 +1,157 @@
+#pragma once
+
+#include "itemtables.h"
+#include "ptadb.h"
+#include "stattable.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+// Stats that have a " (Local)" variant on weapons or armour.
+//
+// A stat line the table matched resolves to its local stat by index. A line
+// that matched no stat only has its text with every number replaced by #, so
+// those are looked up by text instead.
+class LocalTable
+{
+public:
+    // Adds the stats whose text starts with the given line, if the stat table has a local variant of it.
+    // alternate(text) is only available after seal()
+    void add(const StatTable& stats, std::string_view text);
+
+    void seal();
+    void clear();
+
+    void save(ptadb::SectionWriter& w) const;
+    bool restore(ptadb::SectionReader& r);
+
+    size_t size() const { return m_text.size(); }
+
+    // First stat with the local variant of the text, npos if there is none
+    StatTable::index_t alternate(StatTable::index_t stat) const { return (stat < m_alternate.size() ? m_alternate[stat] : StatTable::npos); }
+    StatTable::index_t alternate(std::string_view text) const;
+
+private:
+    std::string_view text(uint32_t i) const { return m_strings.view(m_text[i]); }
+
+private:
+    ptadb::array<StatTable::index_t> m_alternate; // per stat, sized on the first add
+
+    StringPool                       m_strings;
+    ptadb::array<StringPool::ref>    m_text;          // every text added
+    ptadb::array<StatTable::index_t> m_textAlternate; // local stat of every text
+    ptadb::hash_index                m_byText;
+
+    // Build time only
+    std::unordered_set<std::string> m_added;
+};
+
+// Item categories a stat is not searched for, although it shares its text
+// with stats that are.
+//
+// Every stat has a bit per known item category. Categories that are only
+// known to the base table are rare enough to be compared by name.
+class DiscriminatorTable
+{
+public:
+    void add(StatTable::index_t stat, std::string_view category);
+
+    // Sizes the table for statCount stats
+    void seal(size_t statCount);
+    void clear();
+
+    void save(ptadb::SectionWriter& w) const;
+    bool restore(ptadb::SectionReader& r);
+
+    // Number of stats excluded from any category
+    size_t size() const;
+
+    bool excludes(StatTable::index_t stat, item_category_e category, std::string_view categoryName) const
+    {
+        if (stat >= m_masks.size())
+        {
+            return false;
+        }
+
+        if (category < item_category_known)
+        {
+            return (m_masks[stat] & (1u << category));
+        }
+
+        return ((m_masks[stat] & other_bit) && excludesOther(stat, categoryName));
+    }
+
+private:
+    static_assert(item_category_known < 32, "a category mask is 32 bits");
+
+    static constexpr uint32_t other_bit = 1u << 31;
+
+    bool excludesOther(StatTable::index_t stat, std::string_view categoryName) const;
+
+    struct other
+    {
+        StatTable::index_t stat;
+        StringPool::ref    category;
+    };
+
+private:
+    ptadb::array<uint32_t> m_masks; // per stat
+
+    StringPool          m_strings;
+    ptadb::array<other> m_other; // categories not in item_category_e
+};
+
+// Enchant lines the trade site lists under another stat text, or that stand
+// for a fixed value without printing it.
+//
+// Like LocalTable, a rule is found by stat index for lines the table matched
+// and by text for the rest.
+class EnchantTable
+{
+public:
+    struct rule
+    {
+        StatTable::index_t stat        = StatTable::npos; // stat the line is searched as, npos to keep the one it matched
+        bool               hasValue    = false;           // value is added to the values read from the line
+        bool               real        = false;
+        uint8_t            reserved[2] = {};
+        double             value       = 0.0;
+    };
+
+    // Adds the rule for a line with every number replaced by #. find(text) is only available after seal()
+    void add(const StatTable& stats, std::string_view text, const rule& r);
+
+    void seal();
+    void clear();
+
+    void save(ptadb::SectionWriter& w) const;
+    bool restore(ptadb::SectionReader& r);
+
+    size_t size() const { return m_rules.size(); }
+
+    const rule* find(StatTable::index_t stat) const { return (stat < m_byStat.size() && m_byStat[stat] != none ? &m_rules[m_byStat[stat]] : nullptr); }
+    const rule* find(std::string_view text) const;
+
+private:
+    static constexpr uint32_t none = UINT32_MAX;
+
+    std::string_view text(uint32_t i) const { return m_strings.view(m_text[i]); }
+
+private:
+    ptadb::array<rule>     m_rules;
+    ptadb::array<uint32_t> m_byStat; // per stat, sized on the first add of a stat text
+
+    StringPool                    m_strings;
+    ptadb::array<StringPool::ref> m_text; // text of every rule
+    ptadb::hash_index             m_byText;
+
+    // Build time only
+    std::unordered_set<std::string> m_added;
+};
+
+static_assert(sizeof(EnchantTable::rule) == 16, "EnchantTable::rule has padding");
+
+template <>
+inline constexpr bool ptadb::packed<EnchantTable::rule> = true;
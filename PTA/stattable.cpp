@@ -0,0 +1,591 @@
+#include "stattable.h"
+
+#include <algorithm>
+#include <map>
+
+const std::array<const char*, stat_type_known> StatTable::type_names = {
+    "pseudo", "explicit", "implicit", "fractured", "enchant", "crafted", "veiled", "monster", "delve"};
+
+namespace
+{
+    bool isDigit(char c) { return (c >= '0' && c <= '9'); }
+    bool isNumeric(char c) { return (isDigit(c) || c == '.'); }
+    bool isSign(char c) { return (c == '+' || c == '-'); }
+
+    std::string replaceAll(std::string s, std::string_view from, std::string_view to)
+    {
+        for (size_t pos = s.find(from); pos != std::string::npos; pos = s.find(from, pos + to.size()))
+        {
+            s.replace(pos, from.size(), to);
+        }
+
+        return s;
+    }
+
+    // The word a reduced/less form of an increased/more text replaces and what with, both
+    // empty if it has none. Only texts that the item parser would flip straight back get one.
+    std::pair<std::string_view, std::string_view> flipWords(std::string_view text)
+    {
+        if (text.find("reduced") != std::string_view::npos)
+        {
+            return {};
+        }
+
+        if (text.find("increased") != std::string_view::npos)
+        {
+            return {"increased", "reduced"};
+        }
+
+        if (text.find("more") != std::string_view::npos && text.find("less") == std::string_view::npos)
+        {
+            return {"more", "less"};
+        }
+
+        return {};
+    }
+
+    std::string flippedForm(std::string_view text)
+    {
+        auto [from, to] = flipWords(text);
+
+        return (from.empty() ? std::string() : replaceAll(std::string(text), from, to));
+    }
+
+    // Whether a # slot may take the number at pos. Numbers are split like the item parser
+    // does, [+-]?[\d.]+ from left to right, and a slot takes either a whole number or its
+    // digits behind a + the text already has
+    bool slotStart(std::string_view line, size_t pos)
+    {
+        char c = line[pos];
+
+        if (isSign(c))
+        {
+            return (pos + 1 < line.size() && isNumeric(line[pos + 1]));
+        }
+
+        if (!isNumeric(c))
+        {
+            return false;
+        }
+
+        return (pos == 0 || line[pos - 1] == '+' || (!isNumeric(line[pos - 1]) && line[pos - 1] != '-'));
+    }
+
+    // Takes the numbers of a line that fill the # slots of the text it matched, reading every
+    // from in the text as to. False if there are more of them than a match holds
+    bool readValues(std::string_view text, std::string_view line, std::string_view from, std::string_view to, StatTable::Match& out)
+    {
+        size_t pos = 0;
+
+        for (size_t i = 0; i < text.size();)
+        {
+            if (!from.empty() && text.substr(i).starts_with(from))
+            {
+                i += from.size();
+                pos += to.size();
+            }
+            else if (text[i] == '#')
+            {
+                size_t end = pos + ((pos < line.size() && isSign(line[pos])) ? 1 : 0);
+
+                while (end < line.size() && isNumeric(line[end]))
+                {
+                    end++;
+                }
+
+                if (out.count == StatTable::Match::max_values)
+                {
+                    return false;
+                }
+
+                out.values[out.count++] = line.substr(pos, end - pos);
+
+                i++;
+                pos = end;
+            }
+            else
+            {
+                i++;
+                pos++;
+            }
+        }
+
+        return true;
+    }
+
+    // A reading of the template trie while the deterministic one is built: at a node, or
+    // inside a number taken by a # slot that continues at the node
+    enum thread_kind : uint64_t
+    {
+        at_node = 0,
+        slot_start, // the slot takes the next byte, a sign or a numeric one
+        in_slot,    // no digit yet
+        in_slot_digit
+    };
+
+    uint64_t    thread(uint32_t node, thread_kind kind) { return ((uint64_t(node) << 2) | kind); }
+    uint32_t    threadNode(uint64_t t) { return static_cast<uint32_t>(t >> 2); }
+    thread_kind threadKind(uint64_t t) { return static_cast<thread_kind>(t & 3); }
+
+    // Readings in match priority, a reading that is already in keeps its place
+    using thread_set = std::vector<uint64_t>;
+
+    void addThread(thread_set& set, uint64_t t)
+    {
+        if (std::find(set.begin(), set.end(), t) == set.end())
+        {
+            set.push_back(t);
+        }
+    }
+}
+
+StatTable::str_ref StatTable::intern(std::string_view s)
+{
+    auto it = m_interned.find(std::string(s));
+    if (it != m_interned.end())
+    {
+        return {it->second, static_cast<uint32_t>(s.size())};
+    }
+
+    std::vector<char>& pool = m_pool.owned();
+
+    uint32_t offset = static_cast<uint32_t>(pool.size());
+    pool.insert(pool.end(), s.begin(), s.end());
+    m_interned.insert({std::string(s), offset});
+
+    return {offset, static_cast<uint32_t>(s.size())};
+}
+
+StatTable::index_t StatTable::add(std::string_view id, std::string_view text, std::string_view type)
+{
+    index_t idx = static_cast<index_t>(m_id.size());
+
+    m_id.push_back(intern(id));
+
+    // Lines point into the interned text so multi-line stats cost nothing extra
+    str_ref t = intern(text);
+    m_text.push_back(t);
+
+    size_t start = 0;
+
+    while (true)
+    {
+        size_t end = text.find('\n', start);
+
+        if (end == std::string_view::npos)
+        {
+            m_lines.push_back({t.offset + static_cast<uint32_t>(start), static_cast<uint32_t>(text.size() - start)});
+            break;
+        }
+
+        m_lines.push_back({t.offset + static_cast<uint32_t>(start), static_cast<uint32_t>(end - start)});
+        start = end + 1;
+    }
+
+    m_lineBegin.push_back(static_cast<uint32_t>(m_lines.size()));
+
+    auto ti = std::find(m_typeNames.begin(), m_typeNames.end(), type);
+    if (ti == m_typeNames.end())
+    {
+        ti = m_typeNames.insert(m_typeNames.end(), std::string(type));
+    }
+
+    m_type.push_back(static_cast<uint8_t>(std::distance(m_typeNames.begin(), ti)));
+
+    return idx;
+}
+
+void StatTable::seal()
+{
+    m_interned.clear();
+    m_byId.clear();
+    m_byText.clear();
+
+    m_byId.reserve(size());
+
+    for (index_t i = 0; i < size(); i++)
+    {
+        m_byId.insert(ptadb::hash(id(i)), i, [&](uint32_t e) { return id(e) == id(i); });
+    }
+
+    // Group the stats by first line, keeping insertion order within a group
+    std::vector<index_t>    order(size());
+    std::vector<text_range> ranges(size());
+
+    for (index_t i = 0; i < size(); i++)
+    {
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [this](index_t a, index_t b) { return line(a, 0) < line(b, 0); });
+
+    m_byText.reserve(size());
+
+    for (uint32_t begin = 0; begin < order.size();)
+    {
+        std::string_view key = line(order[begin], 0);
+        uint32_t         end = begin + 1;
+
+        while (end < order.size() && line(order[end], 0) == key)
+        {
+            end++;
+        }
+
+        m_byText.insert(ptadb::hash(key), begin, [](uint32_t) { return false; });
+
+        for (uint32_t k = begin; k < end; k++)
+        {
+            ranges[order[k]] = {begin, end};
+        }
+
+        begin = end;
+    }
+
+    m_textOrder.assign(std::move(order));
+    m_textRange.assign(std::move(ranges));
+
+    compile();
+}
+
+void StatTable::compile()
+{
+    std::vector<trie_key> keys;
+    keys.reserve(size() * 2);
+
+    // Reserved up front, the keys point into these
+    std::vector<std::string> flipped;
+    flipped.reserve(size());
+
+    // First stat of every group of stats with the same first line
+    for (uint32_t begin = 0; begin < m_textOrder.size(); begin = m_textRange[m_textOrder[begin]].end)
+    {
+        index_t          stat = m_textOrder[begin];
+        std::string_view text = line(stat, 0);
+
+        keys.push_back({text, stat, false});
+
+        // Without a # there is no value to negate, so the form could never match
+        std::string form = flippedForm(text);
+
+        if (form.find('#') != std::string::npos)
+        {
+            flipped.push_back(std::move(form));
+            keys.push_back({flipped.back(), stat, true});
+        }
+    }
+
+    std::sort(keys.begin(), keys.end(), [](const trie_key& a, const trie_key& b) { return (a.text != b.text ? a.text < b.text : a.flipped < b.flipped); });
+
+    byte_trie<trie_value> tree;
+
+    tree.compile(
+        keys,
+        [](const trie_key& k) { return k.text; },
+        [](trie_value& v, const trie_key& k) {
+            index_t& slot = (k.flipped ? v.flipped : v.exact);
+
+            if (slot == npos)
+            {
+                slot = k.stat;
+            }
+        });
+
+    // Subset construction over the readings of a line. Most nodes stand for a single tree
+    // node and keep its number, the ones where a number is read both ways come after them
+    uint32_t                       treeSize = static_cast<uint32_t>(tree.size());
+    std::vector<thread_set>        merged;
+    std::map<thread_set, uint32_t> ids;
+
+    auto intern = [&](thread_set&& set) -> uint32_t {
+        if (set.size() == 1 && threadKind(set[0]) == at_node)
+        {
+            return threadNode(set[0]);
+        }
+
+        auto [it, added] = ids.try_emplace(set, static_cast<uint32_t>(treeSize + merged.size()));
+
+        if (added)
+        {
+            merged.push_back(std::move(set));
+        }
+
+        return it->second;
+    };
+
+    m_trie.build([&](uint32_t n, state_value& value, std::vector<std::pair<char, uint32_t>>& edges) -> bool {
+        if (n >= treeSize + merged.size())
+        {
+            return false;
+        }
+
+        thread_set set = (n < treeSize ? thread_set{thread(n, at_node)} : merged[n - treeSize]);
+
+        thread_set resolved, slotted;
+        bool       reading = false, starting = false, slots = false;
+
+        for (uint64_t t : set)
+        {
+            uint32_t node = threadNode(t);
+
+            switch (threadKind(t))
+            {
+            case at_node:
+            {
+                const trie_value& v = tree.value(node);
+
+                value.exact   = (value.exact != npos ? value.exact : v.exact);
+                value.flipped = (value.flipped != npos ? value.flipped : v.flipped);
+
+                addThread(resolved, t);
+                addThread(slotted, t);
+
+                // Digits the text spells out come first, then the # slot
+                uint32_t slot = tree.child(node, '#');
+
+                if (slot != npos)
+                {
+                    addThread(slotted, thread(slot, slot_start));
+                    slots = true;
+                }
+                break;
+            }
+            case slot_start:
+                starting = true;
+                addThread(slotted, t);
+                break;
+            case in_slot:
+                reading = true;
+                addThread(slotted, t);
+                break;
+            case in_slot_digit:
+                reading = true;
+                addThread(resolved, thread(node, at_node));
+                addThread(slotted, t);
+                break;
+            }
+        }
+
+        value.resolved = (reading ? intern(std::move(resolved)) : npos);
+        value.slot     = (slots ? intern(std::move(slotted)) : npos);
+
+        // A node reading a number is only left over numeric bytes, the others are taken
+        // from its resolved node. One starting a slot is left over the first byte of a number
+        std::string labels = (reading ? ".0123456789" : starting ? "+-.0123456789" : "");
+
+        if (!reading && !starting)
+        {
+            for (uint64_t t : set)
+            {
+                tree.children(threadNode(t), [&](char label, uint32_t) { labels += label; });
+            }
+        }
+
+        std::sort(labels.begin(), labels.end(), [](char a, char b) { return uint8_t(a) < uint8_t(b); });
+        labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+
+        for (char c : labels)
+        {
+            thread_set next;
+
+            for (uint64_t t : set)
+            {
+                uint32_t node = threadNode(t);
+
+                switch (threadKind(t))
+                {
+                case at_node:
+                {
+                    uint32_t child = tree.child(node, c);
+
+                    if (child != npos)
+                    {
+                        addThread(next, thread(child, at_node));
+                    }
+                    break;
+                }
+                case slot_start:
+                case in_slot:
+                    if (isSign(c) && threadKind(t) == slot_start)
+                    {
+                        addThread(next, thread(node, in_slot));
+                    }
+                    else if (isNumeric(c))
+                    {
+                        addThread(next, thread(node, isDigit(c) ? in_slot_digit : in_slot));
+                    }
+                    break;
+                case in_slot_digit:
+                    if (isNumeric(c))
+                    {
+                        addThread(next, t);
+                    }
+                    break;
+                }
+            }
+
+            if (!next.empty())
+            {
+                edges.emplace_back(c, intern(std::move(next)));
+            }
+        }
+
+        return true;
+    });
+}
+
+bool StatTable::match(std::string_view line, Match& out) const
+{
+    if (m_trie.empty())
+    {
+        return false;
+    }
+
+    uint32_t node = 0;
+
+    for (size_t pos = 0; pos < line.size(); pos++)
+    {
+        char c = line[pos];
+
+        // Numbers taken by # slots end with the first byte that cannot be part of one
+        if (m_trie.value(node).resolved != npos && !isNumeric(c))
+        {
+            node = m_trie.value(node).resolved;
+        }
+
+        if (m_trie.value(node).slot != npos && slotStart(line, pos))
+        {
+            node = m_trie.value(node).slot;
+        }
+
+        node = m_trie.child(node, c);
+
+        if (node == npos)
+        {
+            return false;
+        }
+    }
+
+    if (m_trie.value(node).resolved != npos)
+    {
+        node = m_trie.value(node).resolved;
+    }
+
+    const state_value& v = m_trie.value(node);
+
+    out      = Match();
+    out.stat = (v.exact != npos ? v.exact : v.flipped);
+
+    if (out.stat == npos)
+    {
+        return false;
+    }
+
+    if (v.exact != npos)
+    {
+        return readValues(this->line(out.stat, 0), line, {}, {}, out);
+    }
+
+    auto [from, to] = flipWords(this->line(out.stat, 0));
+
+    out.flipped = true;
+
+    return readValues(this->line(out.stat, 0), line, from, to, out);
+}
+
+void StatTable::clear()
+{
+    m_pool.clear();
+    m_id.clear();
+    m_text.clear();
+    m_type.clear();
+    m_lineBegin = {0};
+    m_lines.clear();
+    m_typeNames.assign(type_names.begin(), type_names.end());
+    m_byId.clear();
+    m_byText.clear();
+    m_textOrder.clear();
+    m_textRange.clear();
+    m_interned.clear();
+    m_trie.clear();
+}
+
+void StatTable::save(ptadb::SectionWriter& w) const
+{
+    w.array(m_pool);
+    w.array(m_id);
+    w.array(m_text);
+    w.array(m_type);
+    w.array(m_lineBegin);
+    w.array(m_lines);
+    w.array(m_byId.slots());
+    w.array(m_byText.slots());
+    w.array(m_textOrder);
+    w.array(m_textRange);
+
+    m_trie.save(w);
+
+    w.u32(static_cast<uint32_t>(m_typeNames.size()));
+
+    for (const auto& t : m_typeNames)
+    {
+        w.str(t);
+    }
+}
+
+bool StatTable::restore(ptadb::SectionReader& r)
+{
+    clear();
+
+    ptadb::array<uint32_t> byId, byText;
+    uint32_t               types = 0;
+
+    bool ok = r.array(m_pool) && r.array(m_id) && r.array(m_text) && r.array(m_type) && r.array(m_lineBegin) && r.array(m_lines) && r.array(byId) &&
+              r.array(byText) && r.array(m_textOrder) && r.array(m_textRange) && m_trie.restore(r) && r.u32(types);
+
+    m_typeNames.clear();
+
+    for (std::string_view t; ok && m_typeNames.size() < types && r.str(t);)
+    {
+        m_typeNames.emplace_back(t);
+    }
+
+    // Only the shape is checked, the contents are trusted like the rest of the snapshot
+    ok = ok && r.valid() && m_typeNames.size() == types && m_byId.restore(byId) && m_byText.restore(byText) && m_text.size() == size() &&
+         m_type.size() == size() && m_lineBegin.size() == size() + 1 && m_textOrder.size() == size() && m_textRange.size() == size();
+
+    if (!ok)
+    {
+        clear();
+    }
+
+    return ok;
+}
+
+StatTable::index_t StatTable::find(std::string_view id) const
+{
+    return m_byId.find(ptadb::hash(id), [&](uint32_t e) { return this->id(e) == id; });
+}
+
+uint32_t StatTable::findText(std::string_view firstLine) const
+{
+    return m_byText.find(ptadb::hash(firstLine), [&](uint32_t e) { return line(m_textOrder[e], 0) == firstLine; });
+}
+
+std::pair<const StatTable::index_t*, const StatTable::index_t*> StatTable::sameText(index_t i) const
+{
+    const index_t* base = m_textOrder.data();
+
+    return {base + m_textRange[i].begin, base + m_textRange[i].end};
+}
+
+std::pair<const StatTable::index_t*, const StatTable::index_t*> StatTable::byText(std::string_view firstLine) const
+{
+    uint32_t begin = findText(firstLine);
+
+    if (begin == npos)
+    {
+        return {nullptr, nullptr};
+    }
+
+    return sameText(m_textOrder[begin]);
+}
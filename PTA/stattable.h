@@ -0,0 +1,179 @@
+#pragma once
+
+#include "bytetrie.h"
+#include "ptadb.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Trade stat types known ahead of time. Types the trade API adds later are
+// interned after stat_type_known and keep their name.
+enum stat_type_e : uint8_t
+{
+    stat_pseudo = 0,
+    stat_explicit,
+    stat_implicit,
+    stat_fractured,
+    stat_enchant,
+    stat_crafted,
+    stat_veiled,
+    stat_monster,
+    stat_delve,
+    stat_type_known
+};
+
+// Flat struct-of-arrays table of the trade API stats.
+//
+// Every stat is addressed by a dense uint32_t index. Strings live in a single
+// interned pool and multi-line texts are split into lines once at build time.
+// Both lookups (by id and by the first line of the text) resolve to indices,
+// so nothing in the table is a JSON object.
+//
+// seal() also compiles the first lines of all stat texts into a trie whose #
+// edges take a number from the item line. The trie is made deterministic right
+// away: where a number could be read both as digits a text spells out and as a
+// # slot, the two readings share one node. An item line is resolved to its
+// template with a single walk from left to right, whatever the number of
+// numbers in it, and the values are then read off along the template, see match().
+//
+// A sealed table is saved as its arrays, lookups and trie included, and a
+// restored one reads them in place from the snapshot.
+class StatTable
+{
+public:
+    using index_t = uint32_t;
+
+    static constexpr index_t npos = UINT32_MAX;
+
+    // An item line resolved to a stat template
+    struct Match
+    {
+        static constexpr size_t max_values = 8;
+
+        index_t                                  stat = npos; // first stat with the matched text
+        std::array<std::string_view, max_values> values;      // numbers taken by # slots, in line order
+        uint8_t                                  count   = 0;
+        bool                                     flipped = false; // reduced/less line matched as increased/more
+    };
+
+    static const std::array<const char*, stat_type_known> type_names;
+
+    // Adds a stat. The lookups are only available after seal()
+    index_t add(std::string_view id, std::string_view text, std::string_view type);
+
+    // Builds the lookups and drops the build time intern table
+    void seal();
+    void clear();
+
+    // Saves a sealed table
+    void save(ptadb::SectionWriter& w) const;
+
+    // Restores a saved table viewing its arrays in place, false if the section is not one
+    bool restore(ptadb::SectionReader& r);
+
+    size_t size() const { return m_id.size(); }
+    bool   empty() const { return m_id.empty(); }
+
+    std::string_view id(index_t i) const { return view(m_id[i]); }
+    std::string_view text(index_t i) const { return view(m_text[i]); }
+    stat_type_e      type(index_t i) const { return static_cast<stat_type_e>(m_type[i]); }
+    std::string_view typeName(index_t i) const { return m_typeNames[m_type[i]]; }
+
+    // Lines of the stat text, the first line included
+    size_t           lineCount(index_t i) const { return m_lineBegin[i + 1] - m_lineBegin[i]; }
+    std::string_view line(index_t i, size_t n) const { return view(m_lines[m_lineBegin[i] + n]); }
+
+    // Lines after the first of a multi-line text
+    size_t           continuationCount(index_t i) const { return lineCount(i) - 1; }
+    std::string_view continuation(index_t i, size_t n) const { return line(i, n + 1); }
+
+    index_t find(std::string_view id) const;
+
+    // Stats whose text starts with the given line, in insertion order
+    std::pair<const index_t*, const index_t*> byText(std::string_view firstLine) const;
+
+    bool containsText(std::string_view firstLine) const { return (findText(firstLine) != npos); }
+
+    // Stats whose text starts with the first line of stat i, i included. Only available after seal()
+    std::pair<const index_t*, const index_t*> sameText(index_t i) const;
+
+    // Resolves an item line to the stat text it was printed from. Numbers in the line
+    // fill # slots, optionally behind a literal +, and digits that are part of the text
+    // itself match as they are. Where a number could do either, the text wins, reading
+    // the line from left to right, so "for 4 seconds" resolves to a stat that spells out
+    // the 4 before one with "for # seconds". "reduced"/"less" lines also match their
+    // "increased"/"more" stat, in which case the last value has to be negated.
+    bool match(std::string_view line, Match& out) const;
+
+private:
+    struct str_ref
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct text_range
+    {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    struct trie_value
+    {
+        index_t exact   = npos; // stat whose first line ends here
+        index_t flipped = npos; // increased/more stat whose reduced/less form ends here
+    };
+
+    // Node of the deterministic trie, standing for every node of the template trie a
+    // line could be at after the same bytes
+    struct state_value
+    {
+        index_t  exact    = npos; // first stat, in match priority, whose first line ends here
+        index_t  flipped  = npos;
+        uint32_t resolved = npos; // node once the numbers being read by # slots end, npos if none are
+        uint32_t slot     = npos; // node once a number starting here is also tried against # slots
+    };
+
+    struct trie_key
+    {
+        std::string_view text;
+        index_t          stat;
+        bool             flipped;
+    };
+
+    str_ref          intern(std::string_view s);
+    std::string_view view(str_ref r) const { return std::string_view(m_pool.data() + r.offset, r.length); }
+
+    // Position in m_textOrder of the first stat whose text starts with firstLine, npos if there is none
+    uint32_t findText(std::string_view firstLine) const;
+
+    void compile();
+
+private:
+    ptadb::array<char> m_pool;
+
+    ptadb::array<str_ref>  m_id;
+    ptadb::array<str_ref>  m_text;
+    ptadb::array<uint8_t>  m_type;
+    ptadb::array<uint32_t> m_lineBegin = {0}; // size() + 1 entries into m_lines
+    ptadb::array<str_ref>  m_lines;
+
+    std::vector<std::string> m_typeNames = {type_names.begin(), type_names.end()};
+
+    // Lookups, comparing against the strings in m_pool
+    ptadb::hash_index        m_byId;      // stat by id
+    ptadb::hash_index        m_byText;    // position in m_textOrder of every first line
+    ptadb::array<index_t>    m_textOrder; // stats grouped by first line
+    ptadb::array<text_range> m_textRange; // range in m_textOrder of every stat
+
+    // Template trie, deterministic
+    byte_trie<state_value> m_trie;
+
+    // Build time only
+    std::unordered_map<std::string, uint32_t> m_interned;
+};
@@ -0,0 +1,165 @@
+// AffixTable::split, which cuts a magic item name into prefix, base and suffix.
+//
+// Builds small affix and base tables by hand and splits magic item names with
+// single and multi-word affixes, names whose base is not known, names whose
+// affixes only leave a known base at a shorter cut, and names with more affix
+// cuts than are tried, on the built tables and again on copies restored from a
+// snapshot. Any split other than the expected one fails the run.
+
+#include "itemtables.h"
+#include "ptadb.h"
+#include "testcheck.h"
+
+#include <string>
+#include <string_view>
+
+namespace
+{
+    using testcheck::check;
+
+    std::string describe(const AffixTable::Split& s)
+    {
+        return "[" + std::string(s.prefix) + "] [" + std::string(s.base) + "] [" + std::string(s.suffix) + "]";
+    }
+
+    void expect(const AffixTable& mods, const BaseTable* bases, std::string_view name, std::string_view prefix, std::string_view base, std::string_view suffix)
+    {
+        AffixTable::Split got  = mods.split(name, bases);
+        AffixTable::Split want = {prefix, base, suffix};
+
+        if (got.prefix != want.prefix || got.base != want.base || got.suffix != want.suffix)
+        {
+            testcheck::fail("split(\"" + std::string(name) + "\"" + (bases ? "" : ", no bases") + "): " + describe(got) + ", expected " + describe(want));
+        }
+    }
+
+
+    void checkTables(const AffixTable& mods, const BaseTable& bases)
+    {
+        check(mods.size() == 10, "duplicate affix names are added once");
+        check(mods.find("of the Lynx") != AffixTable::npos && mods.type(mods.find("of the Lynx")) == mod_generation_type::mod_suffix,
+              "first type of a name wins");
+        check(mods.find("Ring") == AffixTable::npos, "find of an unknown affix");
+
+        // Prefix, suffix, both and neither
+        expect(mods, &bases, "Robust Coral Ring", "Robust", "Coral Ring", "");
+        expect(mods, &bases, "Coral Ring of Skill", "", "Coral Ring", "of Skill");
+        expect(mods, &bases, "Robust Iron Ring of Skill", "Robust", "Iron Ring", "of Skill");
+        expect(mods, &bases, "Coral Ring", "", "Coral Ring", "");
+
+        // Multi-word affixes
+        expect(mods, &bases, "Athlete's Leather Belt of the Lynx", "Athlete's", "Leather Belt", "of the Lynx");
+        expect(mods, &bases, "Leather Belt of the Bear", "", "Leather Belt", "of the Bear");
+
+        // An affix that is also part of the base name only comes off if a known base is left
+        expect(mods, &bases, "Vaal Regalia of Skill", "", "Vaal Regalia", "of Skill");
+        expect(mods, &bases, "Sacrificial Garb", "", "Sacrificial Garb", "");
+        expect(mods, &bases, "Flaring Large Cluster Jewel", "Flaring", "Large Cluster Jewel", "");
+
+        // Only prefix and suffix mods split names
+        expect(mods, &bases, "Ascendant Coral Ring", "", "Ascendant Coral Ring", "");
+
+        // Affixes are whole words
+        expect(mods, &bases, "Robustness Coral Ring", "", "Robustness Coral Ring", "");
+
+        // Unknown bases lose the longest affixes that leave anything
+        expect(mods, &bases, "Robust Opal Ring of Skill", "Robust", "Opal Ring", "of Skill");
+        expect(mods, &bases, "Robust of Skill", "Robust", "of Skill", "");
+
+        // Without a base table every name is split at its longest affixes
+        expect(mods, nullptr, "Vaal Regalia of Skill", "Vaal", "Regalia", "of Skill");
+
+        // An affix never makes up the whole name
+        expect(mods, &bases, "Robust", "", "Robust", "");
+        expect(mods, &bases, "", "", "", "");
+    }
+
+    // Saves a table and restores it from the snapshot image, which has to outlive it
+    template <typename Table>
+    bool roundTrip(const Table& table, Table& restored, std::string& image)
+    {
+        ptadb::SectionWriter section;
+        table.save(section);
+
+        ptadb::Writer writer;
+        writer.add(0, 0, section);
+
+        image = writer.finish();
+
+        ptadb::Reader reader;
+
+        if (!reader.open(image.data(), image.size()))
+        {
+            return false;
+        }
+
+        ptadb::SectionReader in = reader.section(0);
+
+        return (restored.restore(in) && in.atEnd());
+    }
+}
+
+int main()
+{
+    BaseTable bases;
+
+    bases.add("Coral Ring", "accessory.ring", 1);
+    bases.add("Iron Ring", "accessory.ring", 1);
+    bases.add("Leather Belt", "accessory.belt", 1);
+    bases.add("Vaal Regalia", "armour.chest", 0);
+    bases.add("Sacrificial Garb", "armour.chest", 0);
+    bases.add("Large Cluster Jewel", "jewel", 0);
+    bases.seal();
+
+    AffixTable mods;
+
+    mods.add("Robust", mod_generation_type::mod_prefix);
+    mods.add("Vaal", mod_generation_type::mod_prefix); // also the first word of a base
+    mods.add("Sacrificial", mod_generation_type::mod_prefix);
+    mods.add("Athlete's", mod_generation_type::mod_prefix);
+    mods.add("Flaring", mod_generation_type::mod_prefix);
+    mods.add("of the Lynx", mod_generation_type::mod_suffix);
+    mods.add("of the Lynx", mod_generation_type::mod_prefix); // a name only counts once
+    mods.add("of Skill", mod_generation_type::mod_suffix);
+    mods.add("of the Bear", mod_generation_type::mod_suffix);
+    mods.add("Jewel", mod_generation_type::mod_suffix); // ends a base name
+    mods.add("Ascendant", mod_generation_type::mod_unknown);
+    mods.seal();
+
+    checkTables(mods, bases);
+
+    std::string modImage, baseImage;
+    AffixTable  restoredMods;
+    BaseTable   restoredBases;
+
+    check(roundTrip(mods, restoredMods, modImage), "affix table restores");
+    check(roundTrip(bases, restoredBases, baseImage), "base table restores");
+    check(restoredBases.find("Vaal Regalia") != BaseTable::npos && restoredBases.category(restoredBases.find("Vaal Regalia")) == cat_chest,
+          "restored base keeps its category");
+
+    checkTables(restoredMods, restoredBases);
+
+    // Names with more affix cuts than are tried keep the longest ones. The very longest
+    // leaves no known base here, so the one before it has to be kept as well
+    AffixTable  nested;
+    std::string prefix;
+
+    for (char word = 'A'; word <= 'I'; word++)
+    {
+        prefix += (prefix.empty() ? "" : " ") + std::string(1, word);
+        nested.add(prefix, mod_generation_type::mod_prefix);
+    }
+
+    nested.add(prefix + " Coral", mod_generation_type::mod_prefix);
+    nested.seal();
+
+    expect(nested, &bases, "A B C D E F G H I Coral Ring", "A B C D E F G H I", "Coral Ring", "");
+
+    // Nothing to split with an empty table
+    AffixTable empty;
+    empty.seal();
+
+    expect(empty, &bases, "Robust Coral Ring of Skill", "", "Robust Coral Ring of Skill", "");
+
+    return testcheck::report();
+}
@@ -0,0 +1,249 @@
+// ptadbc - PTA dataset compiler
+//
+// Builds the runtime dataset snapshot (.ptadb) that PTA otherwise builds on first
+// start, from local copies of its source documents. No network access is needed.
+// Shipped as data.ptadb next to the executable, it is served on a first start
+// until PTA has a snapshot of its own.
+//
+// The snapshot holds no HTTP validators, the documents were never fetched, so the
+// app downloads every remote source once to check it. Tables are fingerprinted
+// exactly like the app does, so the ones compiled from the documents it downloads
+// are kept as they are and only the changed ones are rebuilt.
+
+#include "dataset.h"
+#include "ptadb.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    enum source_dir : uint8_t
+    {
+        dir_trade = 0,
+        dir_repoe,
+        dir_data,
+        dir_max
+    };
+
+    struct source
+    {
+        dataset_table table;
+        source_dir    dir;
+        const char*   file;
+    };
+
+    // Same documents as ItemAPI loads, under the names they are published as. All of
+    // them are required, the app only serves a snapshot that has every table
+    const std::array<source, table_max> c_sources = {{{table_leagues, dir_trade, "leagues.json"},
+                                                      {table_excludes, dir_data, "excludes.json"},
+                                                      {table_stats, dir_trade, "stats.json"},
+                                                      {table_uniques, dir_trade, "items.json"},
+                                                      {table_base_categories, dir_data, "base_categories.json"},
+                                                      {table_bases, dir_repoe, "base_items.min.json"},
+                                                      {table_mods, dir_repoe, "mods.min.json"},
+                                                      {table_pseudo_rules, dir_data, "pseudo_rules.json"},
+                                                      {table_enchant_rules, dir_data, "enchant_rules.json"},
+                                                      {table_weapon_locals, dir_data, "weapon_locals.json"},
+                                                      {table_armour_locals, dir_data, "armour_locals.json"},
+                                                      {table_discriminators, dir_data, "discriminators.json"},
+                                                      {table_currency, dir_data, "currency.json"}}};
+
+    using clock_type = std::chrono::steady_clock;
+
+    double elapsedMs(clock_type::time_point since)
+    {
+        return std::chrono::duration<double, std::milli>(clock_type::now() - since).count();
+    }
+
+    bool readFile(const std::string& path, std::string& out)
+    {
+        std::ifstream in(path, std::ios::binary);
+
+        if (!in)
+        {
+            return false;
+        }
+
+        out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+        return !in.bad();
+    }
+
+    void usage(const char* argv0)
+    {
+        std::printf("Usage: %s --trade <dir> --repoe <dir> --data <dir> -o <file.ptadb>\n"
+                    "\n"
+                    "  --trade <dir>   trade API documents: leagues.json, stats.json, items.json\n"
+                    "  --repoe <dir>   RePoE documents: base_items.min.json, mods.min.json\n"
+                    "  --data <dir>    PTA rule files, i.e. PTA/data\n"
+                    "  -o <file>       snapshot to write\n"
+                    "  --dom           parse the RePoE documents into a JSON DOM instead of streaming them\n",
+                    argv0);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::array<std::string, dir_max> dirs;
+    std::string                      output;
+    bool                             dom = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg  = argv[i];
+        bool        more = (i + 1 < argc);
+
+        if (arg == "--trade" && more)
+        {
+            dirs[dir_trade] = argv[++i];
+        }
+        else if (arg == "--repoe" && more)
+        {
+            dirs[dir_repoe] = argv[++i];
+        }
+        else if (arg == "--data" && more)
+        {
+            dirs[dir_data] = argv[++i];
+        }
+        else if (arg == "-o" && more)
+        {
+            output = argv[++i];
+        }
+        else if (arg == "--dom")
+        {
+            dom = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return (arg == "-h" || arg == "--help") ? 0 : 1;
+        }
+    }
+
+    if (output.empty() || dirs[dir_trade].empty() || dirs[dir_repoe].empty() || dirs[dir_data].empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Dataset                         data;
+    ptadb::Writer                   out;
+    std::array<uint64_t, table_max> hashes = {};
+
+    std::array<size_t, table_max> sourceBytes = {};
+    std::array<double, table_max> buildMs     = {};
+
+    auto total = clock_type::now();
+
+    // Table order already puts every table after the one it depends on
+    for (const auto& src : c_sources)
+    {
+        std::string path = dirs[src.dir] + "/" + src.file;
+        std::string raw;
+
+        if (!readFile(path, raw))
+        {
+            std::fprintf(stderr, "Cannot read %s\n", path.c_str());
+            return 1;
+        }
+
+        dataset_table dep     = Dataset::dependency(src.table);
+        uint64_t      dephash = (dep != table_max ? hashes[dep] : 0);
+
+        hashes[src.table]      = Dataset::fingerprint(src.table, ptadb::hash(raw.data(), raw.size()), dephash);
+        sourceBytes[src.table] = raw.size();
+
+        auto start = clock_type::now();
+
+        try
+        {
+            if (Dataset::streamable(src.table) && !dom)
+            {
+                std::istringstream in(raw);
+                data.build(src.table, in);
+            }
+            else
+            {
+                data.build(src.table, json::parse(raw.begin(), raw.end()));
+            }
+        } catch (const std::exception& e)
+        {
+            std::fprintf(stderr, "Failed to build %s from %s: %s\n", Dataset::table_names[src.table], path.c_str(), e.what());
+            return 1;
+        }
+
+        buildMs[src.table] = elapsedMs(start);
+
+        data.save(src.table, out, hashes[src.table]);
+    }
+
+    std::string image = out.finish();
+
+    double totalMs = elapsedMs(total);
+
+    std::ofstream file(output, std::ios::binary | std::ios::trunc);
+
+    if (!file || !file.write(image.data(), image.size()))
+    {
+        std::fprintf(stderr, "Cannot write %s\n", output.c_str());
+        return 1;
+    }
+
+    file.close();
+
+    // Time a warm start from the image we just wrote
+    ptadb::Reader reader;
+
+    if (!reader.open(image.data(), image.size()))
+    {
+        std::fprintf(stderr, "Written snapshot does not read back\n");
+        return 1;
+    }
+
+    Dataset                       restored;
+    std::array<double, table_max> restoreMs = {};
+
+    for (uint32_t t = 0; t < table_max; t++)
+    {
+        auto start = clock_type::now();
+
+        if (!restored.restore(static_cast<dataset_table>(t), reader))
+        {
+            std::fprintf(stderr, "Failed to restore %s from the written snapshot\n", Dataset::table_names[t]);
+            return 1;
+        }
+
+        restoreMs[t] = elapsedMs(start);
+    }
+
+    std::printf("\n%-22s %12s %10s %12s %11s\n", "table", "source KiB", "build ms", "section KiB", "restore ms");
+
+    size_t sourceTotal  = 0;
+    double buildTotal   = 0;
+    double restoreTotal = 0;
+
+    for (uint32_t t = 0; t < table_max; t++)
+    {
+        std::printf("%-22s %12.1f %10.2f %12.1f %11.2f\n",
+                    Dataset::table_names[t],
+                    sourceBytes[t] / 1024.0,
+                    buildMs[t],
+                    out.size(t) / 1024.0,
+                    restoreMs[t]);
+
+        sourceTotal += sourceBytes[t];
+        buildTotal += buildMs[t];
+        restoreTotal += restoreMs[t];
+    }
+
+    std::printf("%-22s %12.1f %10.2f %12.1f %11.2f\n", "total", sourceTotal / 1024.0, buildTotal, image.size() / 1024.0, restoreTotal);
+    std::printf("\nWrote %s (%zu bytes) in %.2f ms\n", output.c_str(), image.size(), totalMs);
+
+    return 0;
+}
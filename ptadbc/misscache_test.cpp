@@ -0,0 +1,134 @@
+// StatMissCache under a single thread and under several.
+//
+// Covers lookups and inserts under one data key, the reset when the data key
+// changes, oldest-first eviction once a shard is full, the hit and miss
+// counters, and lookups and inserts from several threads at once.
+
+#include "misscache.h"
+#include "testcheck.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using testcheck::check;
+
+    // Keys that all land in the same shard
+    uint64_t sameShard(uint64_t n)
+    {
+        return (uint64_t(3) << 58) | n;
+    }
+}
+
+int main()
+{
+    {
+        StatMissCache cache;
+
+        uint64_t a = StatMissCache::lineKey("Travel to this Map by using it in a personal Map Device.", 0);
+        uint64_t b = StatMissCache::lineKey("Travel to this Map by using it in a personal Map Device.", 1);
+
+        check(a != b, "variants give different keys");
+
+        // Lines whose first bytes differ in the bits a variant could flip
+        check(StatMissCache::lineKey("12% increased Attack Speed", 0) != StatMissCache::lineKey("22% increased Attack Speed", 1),
+              "variants of different lines give different keys");
+
+        check(!cache.contains(1, a), "empty cache contains nothing");
+
+        cache.insert(1, a);
+
+        check(cache.contains(1, a), "inserted line is found");
+        check(!cache.contains(1, b), "other variant is not found");
+
+        // A new data key empties what was filled under the old one
+        check(!cache.contains(2, a), "line is not found under another data key");
+        check(!cache.contains(1, a), "line is gone after the data key changed");
+
+        StatMissCache::counts c = cache.counters();
+
+        check(c.hits == 1 && c.misses == 4, "hits and misses are counted");
+
+        cache.insert(2, a);
+        cache.clear();
+
+        check(!cache.contains(2, a), "clear empties the cache");
+    }
+
+    {
+        // One line per shard
+        StatMissCache cache(StatMissCache::shard_count);
+
+        cache.insert(1, sameShard(1));
+        cache.insert(1, sameShard(2));
+
+        check(!cache.contains(1, sameShard(1)), "oldest line of a full shard is evicted");
+        check(cache.contains(1, sameShard(2)), "newest line of a full shard stays");
+    }
+
+    {
+        StatMissCache cache(StatMissCache::shard_count * 4);
+
+        for (uint64_t n = 0; n < 6; n++)
+        {
+            cache.insert(1, sameShard(n));
+        }
+
+        // Inserting a line that is already in does not evict anything
+        cache.insert(1, sameShard(5));
+
+        check(!cache.contains(1, sameShard(0)) && !cache.contains(1, sameShard(1)), "lines are evicted oldest first");
+        check(cache.contains(1, sameShard(2)) && cache.contains(1, sameShard(5)), "the newest lines stay");
+    }
+
+    {
+        // Lines of other shards are unaffected by a full shard
+        StatMissCache cache(StatMissCache::shard_count);
+
+        uint64_t other = (uint64_t(4) << 58);
+
+        cache.insert(1, other);
+        cache.insert(1, sameShard(1));
+        cache.insert(1, sameShard(2));
+
+        check(cache.contains(1, other), "other shards keep their lines");
+    }
+
+    {
+        StatMissCache cache;
+
+        constexpr size_t threads = 8;
+        constexpr size_t lookups = 20000;
+
+        std::vector<std::thread> workers;
+
+        for (size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&cache, t]() {
+                for (size_t i = 0; i < lookups; i++)
+                {
+                    uint64_t line = StatMissCache::lineKey(std::to_string(i % 512), static_cast<uint32_t>(t % 2));
+
+                    if (!cache.contains(7, line))
+                    {
+                        cache.insert(7, line);
+                    }
+                }
+            });
+        }
+
+        for (auto& w : workers)
+        {
+            w.join();
+        }
+
+        StatMissCache::counts c = cache.counters();
+
+        check(c.hits + c.misses == threads * lookups, "every lookup from every thread is counted");
+        check(c.misses >= 1024 && c.hits > 0, "lines inserted by one thread are found by the others");
+    }
+
+    return testcheck::report();
+}
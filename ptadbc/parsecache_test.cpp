@@ -0,0 +1,171 @@
+// ParseCache in memory and through its cache file.
+//
+// Covers the normalized text hash, hits and data key mismatches, least
+// recently used eviction, that cached items never keep a dataset generation
+// alive, a save and load round trip of the persisted entries, and that damaged
+// cache files and entries are skipped instead of trusted.
+
+#include "parsecache.h"
+#include "testcheck.h"
+
+#include <cstring>
+#include <memory>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace
+{
+    using testcheck::check;
+
+    Item named(const char* name)
+    {
+        Item item;
+
+        item.rarity = rarity_unique;
+        item.name   = name;
+        item.type   = "Coral Ring";
+        item.set(field_name);
+
+        return item;
+    }
+
+    const QString c_ring = "Rarity: Unique\n"
+                           "Ventor's Gamble\n"
+                           "Gold Ring\n"
+                           "--------\n"
+                           "Item Level: 84\n";
+}
+
+int main()
+{
+    // Everything but the price note and surrounding whitespace counts
+    check(ParseCache::textHash(c_ring) == ParseCache::textHash("  " + c_ring + "\n\n"), "surrounding whitespace is ignored");
+    check(ParseCache::textHash(c_ring) == ParseCache::textHash(c_ring + "--------\nNote: ~price 1 chaos\n"), "the price note is ignored");
+    check(ParseCache::textHash(c_ring) != ParseCache::textHash(QString(c_ring).replace("84", "85")), "other text changes the hash");
+
+    auto gen = std::make_shared<const Dataset>();
+
+    {
+        ParseCache cache;
+        Item       item;
+
+        check(!cache.find(1, 10, gen, item), "empty cache finds nothing");
+
+        cache.insert(1, 10, named("Ventor's Gamble"));
+
+        check(cache.find(1, 10, gen, item) && item.name == "Ventor's Gamble", "inserted item is found");
+        check(item.gen == gen, "found item gets the generation of the lookup");
+
+        // Entries parsed against other tables are dropped on the first lookup
+        check(!cache.find(1, 11, gen, item), "item is not found under another data key");
+        check(!cache.find(1, 10, gen, item), "item is gone after a data key mismatch");
+    }
+
+    {
+        ParseCache cache(2);
+        Item       item;
+
+        cache.insert(1, 10, named("a"));
+        cache.insert(2, 10, named("b"));
+
+        // Using 1 makes 2 the least recently used
+        cache.find(1, 10, gen, item);
+        cache.insert(3, 10, named("c"));
+
+        check(cache.find(1, 10, gen, item) && item.name == "a", "recently used entry stays");
+        check(!cache.find(2, 10, gen, item), "least recently used entry is evicted");
+        check(cache.find(3, 10, gen, item) && item.name == "c", "newest entry stays");
+
+        // Inserting a text again replaces its entry
+        cache.insert(3, 10, named("d"));
+
+        check(cache.find(3, 10, gen, item) && item.name == "d", "insert replaces an entry");
+
+        cache.clear();
+
+        check(!cache.find(1, 10, gen, item), "clear empties the cache");
+    }
+
+    {
+        ParseCache cache;
+        auto       held = std::make_shared<const Dataset>();
+
+        Item item = named("a");
+        item.gen  = held;
+
+        cache.insert(1, 10, item);
+
+        std::weak_ptr<const Dataset> weak = held;
+
+        item.gen.reset();
+        held.reset();
+
+        check(weak.expired(), "cached items do not hold on to their generation");
+    }
+
+    {
+        QTemporaryDir dir;
+        QString       path = dir.filePath("parsecache.json");
+
+        ParseCache cache;
+
+        cache.insert(1, 10, named("a"));
+        cache.insert(2, 11, named("b"));
+        cache.insert(3, 10, named("c"));
+
+        check(cache.save(path, 10, gen), "cache is saved");
+
+        ParseCache loaded;
+        Item       item;
+
+        check(loaded.load(path), "saved cache loads");
+        check(loaded.find(1, 10, gen, item) && item.name == "a", "persisted entry is read back");
+        check(loaded.find(3, 10, gen, item) && item.name == "c" && item.has(field_name), "persisted entries keep their fields");
+        check(!loaded.find(2, 11, gen, item), "entries of other data keys are not persisted");
+
+        // A persisted entry survives a lookup that ran before its tables were loaded
+        ParseCache early;
+
+        early.load(path);
+
+        check(!early.find(1, 9, gen, item), "persisted entry is not handed to other tables");
+        check(early.find(1, 10, gen, item) && item.name == "a", "persisted entry stays for the tables it was parsed against");
+    }
+
+    {
+        QTemporaryDir dir;
+        QString       path = dir.filePath("parsecache.json");
+
+        auto write = [&](const char* doc) {
+            QFile file(path);
+            return (file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(doc) == qint64(std::strlen(doc)));
+        };
+
+        ParseCache cache;
+        Item       item;
+
+        check(write("not json") && !cache.load(path), "a file that is no JSON is not loaded");
+        check(write("[1, 2]") && !cache.load(path), "a file that is no object is not loaded");
+        check(write(R"({"data": "10", "entries": []})") && !cache.load(path), "a file with a data key of the wrong type is not loaded");
+        check(write(R"({"data": 10, "entries": {}})") && !cache.load(path), "a file whose entries are no array is not loaded");
+
+        // Damaged entries are skipped, the others are kept
+        check(write(R"({"data": 10, "entries": [5, {"text": 1}, {"text": "2", "item": {}}, {"item": {}}, {"text": 3, "item": []},
+                                                {"text": 4, "item": {"name": "a", "type": "Coral Ring"}}]})") &&
+                  cache.load(path),
+              "a file with damaged entries loads");
+        check(!cache.find(1, 10, gen, item) && !cache.find(3, 10, gen, item), "damaged entries are skipped");
+        check(cache.find(4, 10, gen, item) && item.name == "a", "intact entries of a damaged file are kept");
+
+        // Fields of the wrong type inside an item only show when it is read back
+        ParseCache typed;
+
+        check(write(R"({"data": 10, "entries": [{"text": 1, "item": {"quality": "high"}}]})") && typed.load(path),
+              "an item with fields of the wrong type loads");
+        check(!typed.find(1, 10, gen, item), "an item with fields of the wrong type is dropped on lookup");
+        check(!typed.find(1, 10, gen, item), "a dropped item stays dropped");
+    }
+
+    return testcheck::report();
+}
@@ -0,0 +1,395 @@
+// Differential check of the propscan number scanners against the regular
+// expressions the item parser used before them.
+//
+// The old readers are kept here as they were, with the QRegularExpression
+// patterns run through std::regex (they only use ^, classes and groups, which
+// read the same in both) and QString::toInt/toDouble spelled out as full-token
+// conversions. Every reader gets a fixed corpus of property, stat and socket
+// lines plus a seeded stream of random ones, and any difference fails the run.
+
+#include "propscan.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // QString::toInt, 0 unless the whole token is an int
+    int qtToInt(const std::string& s)
+    {
+        if (s.empty())
+        {
+            return 0;
+        }
+
+        char* end = nullptr;
+        errno     = 0;
+
+        long long v = std::strtoll(s.c_str(), &end, 10);
+
+        if (errno || *end || end == s.c_str() || v < INT_MIN || v > INT_MAX)
+        {
+            return 0;
+        }
+
+        return static_cast<int>(v);
+    }
+
+    // QString::toDouble, 0 unless the whole token is a number
+    double qtToDouble(const std::string& s)
+    {
+        if (s.empty())
+        {
+            return 0.0;
+        }
+
+        char* end = nullptr;
+        errno     = 0;
+
+        double v = std::strtod(s.c_str(), &end);
+
+        if (errno || *end || end == s.c_str())
+        {
+            return 0.0;
+        }
+
+        return v;
+    }
+
+    void replaceAll(std::string& s, const std::string& what, const std::string& with)
+    {
+        for (size_t pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + with.size()))
+        {
+            s.replace(pos, what.size(), with);
+        }
+    }
+
+    // QString::split with QString::SkipEmptyParts
+    std::vector<std::string> split(const std::string& s, const std::string& sep)
+    {
+        std::vector<std::string> parts;
+        size_t                   begin = 0;
+
+        while (true)
+        {
+            size_t end = s.find(sep, begin);
+
+            std::string part = s.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+
+            if (!part.empty())
+            {
+                parts.push_back(part);
+            }
+
+            if (end == std::string::npos)
+            {
+                return parts;
+            }
+
+            begin = end + sep.size();
+        }
+    }
+
+    const std::regex c_leadingNumber("^([\\+\\-]?[\\d\\.]+)%?");
+    const std::regex c_leadingRange("^(\\d+)-(\\d+)");
+    const std::regex c_number("([\\+\\-]?[\\d\\.]+)");
+
+    int oldReadPropInt(std::string prop)
+    {
+        replaceAll(prop, " (augmented)", "");
+
+        std::smatch match;
+
+        return (std::regex_search(prop, match, c_leadingNumber) ? qtToInt(match[1]) : 0);
+    }
+
+    double oldReadPropFloat(std::string prop)
+    {
+        replaceAll(prop, " (augmented)", "");
+
+        std::smatch match;
+
+        return (std::regex_search(prop, match, c_leadingNumber) ? qtToDouble(match[1]) : 0.0);
+    }
+
+    IntRange oldReadPropIntRange(std::string prop)
+    {
+        IntRange val;
+
+        if (prop.find(", ") != std::string::npos)
+        {
+            for (const auto& item : split(prop, ", "))
+            {
+                IntRange nxt = oldReadPropIntRange(item);
+
+                val.min += nxt.min;
+                val.max += nxt.max;
+            }
+
+            return val;
+        }
+
+        replaceAll(prop, " (augmented)", "");
+
+        std::smatch match;
+
+        if (std::regex_search(prop, match, c_leadingRange))
+        {
+            val.min = qtToInt(match[1]);
+            val.max = qtToInt(match[2]);
+        }
+
+        return val;
+    }
+
+    Item::Sockets oldReadSockets(const std::string& prop)
+    {
+        Item::Sockets sockets;
+
+        for (const auto& lpart : split(prop, " "))
+        {
+            auto socks = split(lpart, "-");
+
+            if (socks.size() > 1 && static_cast<int>(socks.size()) > sockets.links)
+            {
+                sockets.links = static_cast<int>(socks.size());
+            }
+
+            for (const auto& s : socks)
+            {
+                if (s == "R")
+                {
+                    sockets.R++;
+                }
+                else if (s == "G")
+                {
+                    sockets.G++;
+                }
+                else if (s == "B")
+                {
+                    sockets.B++;
+                }
+                else if (s == "W")
+                {
+                    sockets.W++;
+                }
+                else if (s == "A")
+                {
+                    sockets.A++;
+                }
+
+                sockets.total++;
+            }
+        }
+
+        return sockets;
+    }
+
+    void oldCaptureNumerics(const std::string& line, ItemFilter& val)
+    {
+        for (std::sregex_iterator it(line.begin(), line.end(), c_number), end; it != end; ++it)
+        {
+            std::string word = (*it)[1];
+
+            if (word.find('.') != std::string::npos)
+            {
+                val.push(qtToDouble(word), true);
+            }
+            else
+            {
+                val.push(qtToInt(word), false);
+            }
+        }
+    }
+
+    std::string oldMask(const std::string& line, const std::string& mask)
+    {
+        return std::regex_replace(line, c_number, mask);
+    }
+
+    bool sameFilter(const ItemFilter& a, const ItemFilter& b)
+    {
+        return (a.count == b.count && a.real == b.real && a.values == b.values);
+    }
+
+    bool sameSockets(const Item::Sockets& a, const Item::Sockets& b)
+    {
+        return (a.links == b.links && a.total == b.total && a.R == b.R && a.G == b.G && a.B == b.B && a.W == b.W && a.A == b.A);
+    }
+
+    const std::vector<std::string> c_props = {
+        "+20% (augmented)",
+        "20%",
+        "-5",
+        "1.50",
+        "1.5 (augmented)",
+        "+0.5%",
+        ".5",
+        "5.",
+        "1.2.3",
+        "+-3",
+        "--3",
+        "abc",
+        "",
+        "99999999999",
+        "2147483647",
+        "-2147483648",
+        "7.6%",
+        "12-24 (augmented)",
+        "12-24, 3-56 (augmented)",
+        "1-2, , 3-4",
+        "5-",
+        "-5-6",
+        "3-4-5",
+        "12 (augmented)-24",
+        "0-0",
+        "01-007",
+    };
+
+    const std::vector<std::string> c_sockets = {
+        "R-G-B B W",
+        "R-G-B-B-W-A",
+        "R R R",
+        "W-W A",
+        "",
+        " ",
+        "R--G",
+        "-R-",
+        "R  G-B",
+        "X-Y Z",
+        "r-g-b",
+        "G-G-G-G-G-G",
+    };
+
+    const std::vector<std::string> c_stats = {
+        "+45 to maximum Life",
+        "12% increased Attack Speed",
+        "Adds 5 to 10 Fire Damage",
+        "Adds 1.5 to 2.5 Chaos Damage per second",
+        "-7% to Cold Resistance",
+        "+2 to Level of Socketed Gems",
+        "Bow Attacks fire 2 additional Arrows",
+        "0.4% of Physical Attack Damage Leeched as Life",
+        "Has 1 Abyssal Socket",
+        "Socketed Gems are Supported by Level 20 Multistrike",
+        "Area contains 3.2.1 things",
+        "100% increased Quantity of Items found in this Area",
+        "Grants Level 22 Summon Skitterbots Skill",
+        "+1 to Maximum Power Charges and +-1 to Maximum Frenzy Charges",
+        "No numbers at all",
+        "",
+    };
+
+    std::string randomLine(std::mt19937& rng)
+    {
+        static const std::vector<std::string> pieces = {
+            "0", "1", "2", "5", "9", "12", "45", "100", "+", "-", ".", "%", " ", ", ", ",", "-", " (augmented)", "R", "G", "B", "W", "A", "x", "to", "of",
+        };
+
+        std::string line;
+        size_t      n = rng() % 12;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            line += pieces[rng() % pieces.size()];
+        }
+
+        return line;
+    }
+
+    int g_failures = 0;
+
+    template <typename T>
+    void report(const char* reader, const std::string& input, const T& oldValue, const T& newValue)
+    {
+        if (g_failures++ < 20)
+        {
+            std::printf("%s(\"%s\"): old %s, new %s\n", reader, input.c_str(), std::to_string(oldValue).c_str(), std::to_string(newValue).c_str());
+        }
+    }
+
+    void check(const std::string& line)
+    {
+        if (int o = oldReadPropInt(line), n = propscan::readInt(line); o != n)
+        {
+            report("readInt", line, o, n);
+        }
+
+        if (double o = oldReadPropFloat(line), n = propscan::readFloat(line); o != n)
+        {
+            report("readFloat", line, o, n);
+        }
+
+        IntRange ro = oldReadPropIntRange(line);
+        IntRange rn = propscan::readIntRange(line);
+
+        if (ro.min != rn.min || ro.max != rn.max)
+        {
+            report("readIntRange", line, ro.min * 1000000LL + ro.max, rn.min * 1000000LL + rn.max);
+        }
+
+        Item::Sockets so = oldReadSockets(line);
+        Item::Sockets sn = propscan::readSockets(line);
+
+        if (!sameSockets(so, sn))
+        {
+            report("readSockets", line, so.total * 100 + so.links, sn.total * 100 + sn.links);
+        }
+
+        ItemFilter fo, fn;
+
+        oldCaptureNumerics(line, fo);
+        propscan::readNumerics(line, fn);
+
+        if (!sameFilter(fo, fn))
+        {
+            report("readNumerics", line, static_cast<int>(fo.count), static_cast<int>(fn.count));
+        }
+
+        // Masked against its own template, and against the template of the other mask
+        for (const std::string mask : {"#", "+#"})
+        {
+            std::string pattern = oldMask(line, mask);
+
+            for (const std::string& p : {pattern, oldMask(line, (mask == "#" ? "+#" : "#"))})
+            {
+                if (bool o = (oldMask(line, mask) == p), n = propscan::matchesMasked(line, p, mask); o != n)
+                {
+                    report("matchesMasked", line + "\" ~ \"" + p + "\" with \"" + mask, static_cast<int>(o), static_cast<int>(n));
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    size_t lines = 0;
+
+    for (const auto* corpus : {&c_props, &c_sockets, &c_stats})
+    {
+        for (const auto& line : *corpus)
+        {
+            check(line);
+            lines++;
+        }
+    }
+
+    std::mt19937 rng(20200101);
+
+    for (size_t i = 0; i < 50000; i++)
+    {
+        check(randomLine(rng));
+        lines++;
+    }
+
+    std::printf("%zu lines checked, %d difference(s)\n", lines, g_failures);
+
+    return (g_failures ? 1 : 0);
+}
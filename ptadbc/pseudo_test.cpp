@@ -0,0 +1,142 @@
+// Item::computePseudos, which sums the stats of an item up into pseudo stats.
+//
+// Builds a small stat table and pseudo rules and checks that terms that add
+// sum the values of every stat feeding them, that other terms keep the values
+// of the first stat, that integer values are cut to whole numbers before they
+// are summed while float values are not, and that a batch of items gets the
+// same pseudos as items done one at a time.
+
+#include "dataset.h"
+#include "pitem.h"
+#include "testcheck.h"
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+    using testcheck::check;
+
+    std::shared_ptr<const Dataset> dataset()
+    {
+        auto gen = std::make_shared<Dataset>();
+
+        gen->build(table_stats, json::parse(R"({"result": [{"entries": [
+            {"id": "explicit.life", "text": "+# to maximum Life", "type": "explicit"},
+            {"id": "implicit.life", "text": "+# to maximum Life", "type": "implicit"},
+            {"id": "explicit.fire", "text": "+#% to Fire Resistance", "type": "explicit"},
+            {"id": "implicit.fire", "text": "+#% to Fire Resistance", "type": "implicit"},
+            {"id": "explicit.adds", "text": "Adds # to # Fire Damage", "type": "explicit"},
+            {"id": "crafted.adds", "text": "Adds # to # Fire Damage", "type": "crafted"},
+            {"id": "pseudo.life", "text": "+# total maximum Life", "type": "pseudo"},
+            {"id": "pseudo.fire", "text": "+#% total to Fire Resistance", "type": "pseudo"},
+            {"id": "pseudo.first_fire", "text": "+#% first Fire Resistance", "type": "pseudo"},
+            {"id": "pseudo.half_life", "text": "+# half maximum Life", "type": "pseudo"},
+            {"id": "pseudo.adds", "text": "Adds # to # total Fire Damage", "type": "pseudo"}]}]})"));
+
+        gen->build(table_pseudo_rules, json::parse(R"({
+            "explicit.life": [{"id": "pseudo.life", "op": "add", "factor": 1}, {"id": "pseudo.half_life", "op": "add", "factor": 0.5}],
+            "implicit.life": [{"id": "pseudo.life", "op": "add", "factor": 1}, {"id": "pseudo.half_life", "op": "add", "factor": 0.5}],
+            "explicit.fire": [{"id": "pseudo.fire", "op": "add", "factor": 1}, {"id": "pseudo.first_fire", "factor": 1}],
+            "implicit.fire": [{"id": "pseudo.fire", "op": "add", "factor": 1}, {"id": "pseudo.first_fire", "factor": 1}],
+            "explicit.adds": [{"id": "pseudo.adds", "op": "add", "factor": 1}],
+            "crafted.adds": [{"id": "pseudo.adds", "op": "add", "factor": 1}]})"));
+
+        return gen;
+    }
+
+    ItemFilter filter(const StatTable& stats, const char* id, std::initializer_list<double> values, bool real = false)
+    {
+        ItemFilter f;
+
+        f.stat = stats.find(id);
+
+        for (double v : values)
+        {
+            f.push(v, real);
+        }
+
+        return f;
+    }
+
+    // Values of the pseudo stat id, empty if the item has none
+    std::vector<double> pseudo(Item& item, const char* id)
+    {
+        const ItemFilter* f = item.pseudo(item.gen->stats().find(id));
+
+        return (f ? std::vector<double>(f->values.begin(), f->values.begin() + f->count) : std::vector<double>());
+    }
+}
+
+int main()
+{
+    auto             gen   = dataset();
+    const StatTable& stats = gen->stats();
+
+    check(gen->pseudos().slots() == 5, "every pseudo stat gets a slot");
+
+    Item armour;
+
+    armour.gen = gen;
+    armour.filters.push_back(filter(stats, "implicit.life", {25}));
+    armour.filters.push_back(filter(stats, "explicit.life", {7}));
+    armour.filters.push_back(filter(stats, "explicit.fire", {30}));
+    armour.filters.push_back(filter(stats, "implicit.fire", {12}));
+    armour.computePseudos();
+
+    check(armour.pseudos.size() == 4, "only fed pseudo stats are listed");
+    check(pseudo(armour, "pseudo.life") == std::vector<double>{32}, "adding terms sum up");
+    check(pseudo(armour, "pseudo.fire") == std::vector<double>{42}, "adding terms sum up over stat types");
+    check(pseudo(armour, "pseudo.first_fire") == std::vector<double>{30}, "other terms keep the first value");
+    check(pseudo(armour, "pseudo.adds").empty(), "pseudo stats without a stat feeding them are left out");
+
+    // 25 * 0.5 and 7 * 0.5 are cut to 12 and 3 before they are summed
+    check(pseudo(armour, "pseudo.half_life") == std::vector<double>{15}, "integer values are cut before they are summed");
+    check(!armour.pseudo(stats.find("pseudo.half_life"))->isReal(0), "integer sums stay integers");
+
+    Item weapon;
+
+    weapon.gen = gen;
+    weapon.filters.push_back(filter(stats, "explicit.adds", {1.5, 10.25}, true));
+    weapon.filters.push_back(filter(stats, "crafted.adds", {2, 3}, true));
+    weapon.filters.push_back(filter(stats, "explicit.life", {9}, true));
+    weapon.filters.push_back(filter(stats, "implicit.life", {9}, true));
+    weapon.computePseudos();
+
+    check(pseudo(weapon, "pseudo.adds") == std::vector<double>{3.5, 13.25}, "every value of a stat is summed");
+    check(weapon.pseudo(stats.find("pseudo.adds"))->isReal(1), "the first stat says which values are floats");
+    check(pseudo(weapon, "pseudo.half_life") == std::vector<double>{9}, "float values are not cut");
+
+    // Values past the count of the first stat are dropped
+    Item ring;
+
+    ring.gen = gen;
+    ring.filters.push_back(filter(stats, "explicit.adds", {4}));
+    ring.filters.push_back(filter(stats, "crafted.adds", {2, 3}));
+    ring.computePseudos();
+
+    check(pseudo(ring, "pseudo.adds") == std::vector<double>{6}, "values the first stat does not have are not summed");
+
+    // The batch gets the same pseudos, and items in it do not feed each other
+    std::vector<Item> copies = {armour, weapon, ring};
+
+    for (auto& item : copies)
+    {
+        item.pseudos.clear();
+    }
+
+    Item::computePseudos({&copies[0], &copies[1], &copies[2]});
+
+    check(pseudo(copies[0], "pseudo.life") == pseudo(armour, "pseudo.life") && pseudo(copies[0], "pseudo.half_life") == pseudo(armour, "pseudo.half_life"),
+          "batch sums the first item alone");
+    check(pseudo(copies[1], "pseudo.adds") == pseudo(weapon, "pseudo.adds"), "batch sums the second item alone");
+    check(pseudo(copies[2], "pseudo.adds") == pseudo(ring, "pseudo.adds") && copies[2].pseudos.size() == 1, "batch sums the last item alone");
+
+    // Recomputing replaces the pseudos
+    armour.filters.clear();
+    armour.computePseudos();
+
+    check(armour.pseudos.empty(), "an item without stats has no pseudos");
+
+    return testcheck::report();
+}
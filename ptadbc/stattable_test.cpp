@@ -0,0 +1,209 @@
+// StatTable::match, which resolves an item line to its stat template.
+//
+// Builds a small stat table by hand and resolves item lines against it: exact
+// texts, # slots with and without a literal +, digits that are part of a text,
+// reduced/less lines matched as their increased/more stat, and the lines of
+// multi-line texts. The same checks run again on a copy of the table restored
+// from a snapshot. Any line that resolves to another stat or other values
+// fails the run.
+
+#include "ptadb.h"
+#include "stattable.h"
+#include "testcheck.h"
+
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    using testcheck::check;
+
+    void fail(std::string_view line, const std::string& what)
+    {
+        testcheck::fail("match(\"" + std::string(line) + "\"): " + what);
+    }
+
+    std::string describe(const StatTable& stats, const StatTable::Match& m)
+    {
+        std::string out = (m.stat == StatTable::npos ? std::string("no stat") : std::string(stats.id(m.stat)));
+
+        out += " [";
+
+        for (size_t i = 0; i < m.count; i++)
+        {
+            out += (i ? ", " : "");
+            out += m.values[i];
+        }
+
+        out += "]";
+
+        if (m.flipped)
+        {
+            out += " flipped";
+        }
+
+        return out;
+    }
+
+    // Expects line to resolve to the stat with the given id and values
+    void expect(const StatTable& stats, std::string_view line, std::string_view id, std::initializer_list<std::string_view> values, bool flipped = false)
+    {
+        StatTable::Match m;
+
+        if (!stats.match(line, m))
+        {
+            fail(line, "no match, expected " + std::string(id));
+            return;
+        }
+
+        StatTable::Match want;
+        want.stat    = stats.find(id);
+        want.flipped = flipped;
+
+        for (auto v : values)
+        {
+            want.values[want.count++] = v;
+        }
+
+        bool same = (m.stat == want.stat && m.count == want.count && m.flipped == want.flipped);
+
+        for (size_t i = 0; same && i < m.count; i++)
+        {
+            same = (m.values[i] == want.values[i]);
+        }
+
+        if (!same)
+        {
+            fail(line, describe(stats, m) + ", expected " + describe(stats, want));
+        }
+    }
+
+    void expectNone(const StatTable& stats, std::string_view line)
+    {
+        StatTable::Match m;
+
+        if (stats.match(line, m))
+        {
+            fail(line, describe(stats, m) + ", expected no match");
+        }
+    }
+
+
+    void checkTable(const StatTable& stats)
+    {
+        // Exact texts and plain slots
+        expect(stats, "Your Hits can't be Evaded", "no_number", {});
+        expect(stats, "+45 to maximum Life", "life", {"45"});
+        expect(stats, "-12% to Fire Resistance", "fire_res", {"-12"});
+        expect(stats, "+30% to Fire Resistance", "fire_res", {"+30"});
+        expect(stats, "12.5% increased Spell Damage", "spell_damage", {"12.5"});
+        expect(stats, "Adds 3 to 7 Fire Damage", "adds_fire", {"3", "7"});
+        expect(stats, "+2 to Level of Socketed Gems", "gem_level", {"2"});
+        expect(stats, "Grants Level 20 Anger Skill", "grants_level", {"20"});
+
+        // Digits the text spells out beat a # slot
+        expect(stats, "10% chance to gain Onslaught for 4 seconds on Kill", "onslaught_4", {"10"});
+        expect(stats, "10% chance to gain Onslaught for 3 seconds on Kill", "onslaught", {"10", "3"});
+        expect(stats, "10% chance to gain Onslaught for 40 seconds on Kill", "onslaught", {"10", "40"});
+        expect(stats, "Adds 1 to 50 Lightning Damage", "adds_lightning_1", {"50"});
+        expectNone(stats, "Adds 2 to 50 Lightning Damage");
+
+        // The spelled out digits lose once the rest of the line only fits the # slot
+        expect(stats, "Adds 1 to 50 Fire Damage", "adds_fire", {"1", "50"});
+
+        // reduced/less lines match their increased/more stat
+        expect(stats, "8% reduced Movement Speed", "ms", {"8"}, true);
+        expect(stats, "15% less Damage", "more_damage", {"15"}, true);
+        expect(stats, "15% more Damage", "more_damage", {"15"});
+
+        // A stat with the reduced text itself is never flipped
+        expect(stats, "10% reduced Cold Damage taken", "cold_reduced", {"10"});
+        expect(stats, "10% increased Cold Damage taken", "cold_increased", {"10"});
+
+        // Without a number there is nothing to negate
+        expectNone(stats, "reduced Movement Speed");
+
+        expectNone(stats, "+45 to maximum Mana");
+        expectNone(stats, "");
+
+        // Multi-line texts match on their first line, first stat of the text in insertion order
+        expect(stats, "Minions deal 20% increased Damage", "minion", {"20"});
+
+        StatTable::index_t minion = stats.find("minion");
+
+        check(stats.lineCount(minion) == 2, "minion has two lines");
+        check(stats.continuationCount(minion) == 1, "minion has one continuation line");
+        check(stats.line(minion, 0) == "Minions deal #% increased Damage", "first line of minion");
+        check(stats.continuation(minion, 0) == "Minions have #% increased Attack Speed", "continuation of minion");
+        check(stats.text(minion) == "Minions deal #% increased Damage\nMinions have #% increased Attack Speed", "text of minion");
+
+        auto same = stats.sameText(minion);
+        check(same.second - same.first == 3, "three stats share the first line of minion");
+        check(same.first[0] == minion && same.first[1] == stats.find("minion_other") && same.first[2] == stats.find("minion_single"),
+              "stats sharing a first line keep insertion order");
+
+        auto life = stats.byText("+# to maximum Life");
+        check(life.second - life.first == 2 && life.first[0] == stats.find("life") && life.first[1] == stats.find("life_implicit"),
+              "byText of +# to maximum Life");
+        check(stats.type(stats.find("life_implicit")) == stat_implicit, "type of life_implicit");
+
+        check(stats.find("unknown") == StatTable::npos, "find of an unknown id");
+        check(!stats.containsText("Minions have #% increased Attack Speed"), "continuation lines are not first lines");
+    }
+}
+
+int main()
+{
+    StatTable stats;
+
+    stats.add("life", "+# to maximum Life", "explicit");
+    stats.add("life_implicit", "+# to maximum Life", "implicit");
+    stats.add("fire_res", "#% to Fire Resistance", "explicit");
+    stats.add("spell_damage", "#% increased Spell Damage", "explicit");
+    stats.add("ms", "#% increased Movement Speed", "explicit");
+    stats.add("more_damage", "#% more Damage", "explicit");
+    stats.add("adds_fire", "Adds # to # Fire Damage", "explicit");
+    stats.add("adds_lightning_1", "Adds 1 to # Lightning Damage", "explicit");
+    stats.add("onslaught", "#% chance to gain Onslaught for # seconds on Kill", "explicit");
+    stats.add("onslaught_4", "#% chance to gain Onslaught for 4 seconds on Kill", "explicit");
+    stats.add("gem_level", "+# to Level of Socketed Gems", "explicit");
+    stats.add("grants_level", "Grants Level # Anger Skill", "explicit");
+    stats.add("no_number", "Your Hits can't be Evaded", "explicit");
+    stats.add("cold_reduced", "#% reduced Cold Damage taken", "explicit");
+    stats.add("cold_increased", "#% increased Cold Damage taken", "explicit");
+    stats.add("minion", "Minions deal #% increased Damage\nMinions have #% increased Attack Speed", "explicit");
+    stats.add("minion_other", "Minions deal #% increased Damage\nMinions have #% increased Movement Speed", "explicit");
+    stats.add("minion_single", "Minions deal #% increased Damage", "explicit");
+
+    stats.seal();
+
+    checkTable(stats);
+
+    // A restored table views the saved arrays in place and answers the same
+    ptadb::SectionWriter section;
+    stats.save(section);
+
+    ptadb::Writer writer;
+    writer.add(0, 0, section);
+
+    std::string   image = writer.finish();
+    ptadb::Reader reader;
+
+    check(reader.open(image.data(), image.size()), "snapshot opens");
+
+    ptadb::SectionReader in = reader.section(0);
+    StatTable            restored;
+
+    check(restored.restore(in) && in.atEnd(), "saved table restores");
+    check(restored.size() == stats.size(), "restored table has every stat");
+
+    checkTable(restored);
+
+    // A section that is not a table leaves nothing behind
+    ptadb::SectionReader none;
+    check(!restored.restore(none) && restored.empty(), "restoring an invalid section fails");
+
+    return testcheck::report();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Failure counting shared by the behavioural checks. A check that fails prints
+// what it expected and the run fails once main returns report().
+
+#include <cstdio>
+#include <string>
+
+namespace testcheck
+{
+    inline int failures = 0;
+
+    inline void fail(const std::string& what)
+    {
+        failures++;
+        std::printf("%s\n", what.c_str());
+    }
+
+    inline void check(bool ok, const char* what)
+    {
+        if (!ok)
+        {
+            fail(what);
+        }
+    }
+
+    // Prints the tally, the exit code of the run
+    inline int report()
+    {
+        std::printf("%d failure(s)\n", failures);
+
+        return (failures ? 1 : 0);
+    }
+}